@@ -1,7 +1,18 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import climate, binary_sensor
-from esphome.const import CONF_ID
+from esphome.components import climate, binary_sensor, sensor, web_server_base
+from esphome.components.web_server_base import CONF_WEB_SERVER_BASE_ID
+from esphome.const import (
+    CONF_HOST,
+    CONF_ID,
+    CONF_PORT,
+    CONF_SENSOR,
+    CONF_SIZE,
+    CONF_TYPE,
+    DEVICE_CLASS_DURATION,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_HOUR,
+)
 from esphome import pins
 
 
@@ -19,18 +30,126 @@ CONF_AC_RX_PIN = 'ac_rx_pin'
 CONF_PANEL_TX_PIN = 'panel_tx_pin'
 CONF_PANEL_RX_PIN = 'panel_rx_pin'
 CONF_WATER_FULL_SENSOR = 'water_full_sensor'
+CONF_PASSTHROUGH = 'passthrough'
+CONF_WIFI_ICON = 'wifi_icon'
+CONF_BEEP_POLICY = 'beep_policy'
+CONF_DISPLAY_OVERRIDE = 'display_override'
+CONF_THERMOSTAT = 'thermostat'
+CONF_HYSTERESIS = 'hysteresis'
+CONF_KP = 'kp'
+CONF_KI = 'ki'
+CONF_KD = 'kd'
+CONF_WATER_FULL_EVENTS = 'water_full_events'
+CONF_TELEMETRY = 'telemetry'
+CONF_INTERVAL = 'interval'
+CONF_KEEPALIVE_INTERVAL = 'keepalive_interval'
+CONF_HISTORY = 'history'
+
+JHSBeepPolicy = JHSClimateComponent_ns.enum("JHSBeepPolicy")
+BEEP_POLICIES = {
+    "normal": JHSBeepPolicy.JHS_BEEP_POLICY_NORMAL,
+    "mute_while_adjusting": JHSBeepPolicy.JHS_BEEP_POLICY_MUTE_WHILE_ADJUSTING,
+    "mute": JHSBeepPolicy.JHS_BEEP_POLICY_MUTE,
+}
+
+JHSThermostatType = JHSClimateComponent_ns.enum("JHSThermostatType")
+THERMOSTAT_TYPES = {
+    "hysteresis": JHSThermostatType.JHS_THERMOSTAT_HYSTERESIS,
+    "pid": JHSThermostatType.JHS_THERMOSTAT_PID,
+}
+
+THERMOSTAT_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_TYPE, default="hysteresis"): cv.enum(THERMOSTAT_TYPES, lower=True),
+        cv.Optional(CONF_HYSTERESIS, default=0.5): cv.positive_float,
+        cv.Optional(CONF_KP, default=2.0): cv.float_,
+        cv.Optional(CONF_KI, default=0.0): cv.float_,
+        cv.Optional(CONF_KD, default=0.0): cv.float_,
+    }
+)
+
+JHSRuntimeCounter = JHSClimateComponent_ns.enum("JHSRuntimeCounter")
+RUNTIME_SENSORS = {
+    "cool_runtime": JHSRuntimeCounter.JHS_RUNTIME_COOL,
+    "dehum_runtime": JHSRuntimeCounter.JHS_RUNTIME_DEHUM,
+    "fan_only_runtime": JHSRuntimeCounter.JHS_RUNTIME_FAN_ONLY,
+    "fan_low_runtime": JHSRuntimeCounter.JHS_RUNTIME_FAN_LOW,
+    "fan_high_runtime": JHSRuntimeCounter.JHS_RUNTIME_FAN_HIGH,
+    "sleep_runtime": JHSRuntimeCounter.JHS_RUNTIME_SLEEP,
+    "water_full_duration": JHSRuntimeCounter.JHS_RUNTIME_WATER_FULL,
+}
+
+RUNTIME_SENSOR_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_HOUR,
+    accuracy_decimals=2,
+    device_class=DEVICE_CLASS_DURATION,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+)
+
+TELEMETRY_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_HOST): cv.ipv4,
+        cv.Optional(CONF_PORT, default=7411): cv.port,
+        cv.Optional(CONF_INTERVAL, default="1s"): cv.positive_time_period_milliseconds,
+    }
+)
+
+HISTORY_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(CONF_WEB_SERVER_BASE_ID): cv.use_id(web_server_base.WebServerBase),
+        # memory budget of the ring in bytes, a state transition takes 2 to 4
+        cv.Optional(CONF_SIZE, default=4096): cv.int_range(min=256, max=32768),
+    }
+)
+
+DISPLAY_CHARS = "0123456789ABCDEFdhH"
+
+
+def validate_display_text(value):
+    value = cv.string_strict(value)
+    if len(value) != 2:
+        raise cv.Invalid("Display text must be exactly 2 characters long")
+    for c in value:
+        if c not in DISPLAY_CHARS:
+            raise cv.Invalid(f"Character '{c}' cannot be shown on the display, use one of: {DISPLAY_CHARS}")
+    return value
+
+
+def validate_passthrough(config):
+    if config[CONF_PASSTHROUGH] and CONF_PANEL_TX_PIN not in config:
+        raise cv.Invalid("passthrough needs the panel pins, it cannot be used in headless mode")
+    return config
 
-CONFIG_SCHEMA = climate.CLIMATE_SCHEMA.extend(
+
+CONFIG_SCHEMA = cv.All(climate.CLIMATE_SCHEMA.extend(
     {
         cv.GenerateID(): cv.declare_id(JHSClimateComponent),
         cv.Required(CONF_AC_TX_PIN): pins.gpio_output_pin_schema,
         cv.Required(CONF_AC_RX_PIN): pins.gpio_input_pin_schema,
-        cv.Required(CONF_PANEL_TX_PIN): pins.gpio_output_pin_schema,
-        cv.Required(CONF_PANEL_RX_PIN): pins.gpio_input_pin_schema,
+        # without the panel pins the component runs headless and emulates the panel
+        cv.Optional(CONF_PANEL_TX_PIN): pins.gpio_output_pin_schema,
+        cv.Optional(CONF_PANEL_RX_PIN): pins.gpio_input_pin_schema,
+        # a panel frame takes 23 to 25 ms on the wire, the next one must not start before it ended
+        cv.Optional(CONF_KEEPALIVE_INTERVAL, default="100ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(min=cv.TimePeriod(milliseconds=30), max=cv.TimePeriod(milliseconds=1000)),
+        ),
         cv.Required(CONF_WATER_FULL_SENSOR): binary_sensor.binary_sensor_schema(),
-        
+        cv.Optional(CONF_PASSTHROUGH, default=False): cv.boolean,
+        cv.Optional(CONF_SENSOR): cv.use_id(sensor.Sensor),
+        cv.Optional(CONF_THERMOSTAT, default={}): THERMOSTAT_SCHEMA,
+        **{cv.Optional(key): RUNTIME_SENSOR_SCHEMA for key in RUNTIME_SENSORS},
+        cv.Optional(CONF_TELEMETRY): TELEMETRY_SCHEMA,
+        cv.Optional(CONF_HISTORY): HISTORY_SCHEMA,
+        cv.Optional(CONF_WATER_FULL_EVENTS): sensor.sensor_schema(
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+        ),
+        cv.Optional(CONF_WIFI_ICON, default=True): cv.boolean,
+        cv.Optional(CONF_BEEP_POLICY, default="mute_while_adjusting"): cv.enum(BEEP_POLICIES, lower=True),
+        cv.Optional(CONF_DISPLAY_OVERRIDE): validate_display_text,
     }
-)
+), cv.has_none_or_all_keys(CONF_PANEL_TX_PIN, CONF_PANEL_RX_PIN), validate_passthrough)
 
 
 async def to_code(config):
@@ -43,9 +162,44 @@ async def to_code(config):
 
     ac_tx_pin = await cg.gpio_pin_expression(config[CONF_AC_TX_PIN])
     ac_rx_pin = await cg.gpio_pin_expression(config[CONF_AC_RX_PIN])
-    panel_tx_pin = await cg.gpio_pin_expression(config[CONF_PANEL_TX_PIN])
-    panel_rx_pin = await cg.gpio_pin_expression(config[CONF_PANEL_RX_PIN])
     cg.add(var.set_ac_tx_pin(ac_tx_pin))
     cg.add(var.set_ac_rx_pin(ac_rx_pin))
-    cg.add(var.set_panel_tx_pin(panel_tx_pin))
-    cg.add(var.set_panel_rx_pin(panel_rx_pin))
+    if CONF_PANEL_TX_PIN in config:
+        panel_tx_pin = await cg.gpio_pin_expression(config[CONF_PANEL_TX_PIN])
+        panel_rx_pin = await cg.gpio_pin_expression(config[CONF_PANEL_RX_PIN])
+        cg.add(var.set_panel_tx_pin(panel_tx_pin))
+        cg.add(var.set_panel_rx_pin(panel_rx_pin))
+    cg.add(var.set_keepalive_interval(config[CONF_KEEPALIVE_INTERVAL]))
+    cg.add(var.set_passthrough(config[CONF_PASSTHROUGH]))
+
+    if CONF_SENSOR in config:
+        room_sensor = await cg.get_variable(config[CONF_SENSOR])
+        cg.add(var.set_room_sensor(room_sensor))
+        thermostat = config[CONF_THERMOSTAT]
+        cg.add(var.set_thermostat_type(thermostat[CONF_TYPE]))
+        cg.add(var.set_thermostat_hysteresis(thermostat[CONF_HYSTERESIS]))
+        cg.add(var.set_thermostat_pid(thermostat[CONF_KP], thermostat[CONF_KI], thermostat[CONF_KD]))
+
+    for key, counter in RUNTIME_SENSORS.items():
+        if key in config:
+            runtime_sensor = await sensor.new_sensor(config[key])
+            cg.add(var.set_runtime_sensor(counter, runtime_sensor))
+    if CONF_WATER_FULL_EVENTS in config:
+        water_full_events = await sensor.new_sensor(config[CONF_WATER_FULL_EVENTS])
+        cg.add(var.set_water_full_events_sensor(water_full_events))
+
+    if CONF_TELEMETRY in config:
+        telemetry = config[CONF_TELEMETRY]
+        cg.add(var.set_telemetry(str(telemetry[CONF_HOST]), telemetry[CONF_PORT], telemetry[CONF_INTERVAL]))
+
+    if CONF_HISTORY in config:
+        history = config[CONF_HISTORY]
+        cg.add_define("USE_JHS_HISTORY")
+        base = await cg.get_variable(history[CONF_WEB_SERVER_BASE_ID])
+        cg.add(var.set_web_server_base(base))
+        cg.add(var.set_history_size(history[CONF_SIZE]))
+
+    cg.add(var.set_wifi_icon(config[CONF_WIFI_ICON]))
+    cg.add(var.set_beep_policy(config[CONF_BEEP_POLICY]))
+    if CONF_DISPLAY_OVERRIDE in config:
+        cg.add(var.set_display_override(config[CONF_DISPLAY_OVERRIDE]))
@@ -3,12 +3,16 @@
 #include "esphome/core/log.h"
 #include "esp32-hal-rmt.h"
 #include "soc/rmt_struct.h"
+#include "soc/gpio_struct.h"
+#include "soc/gpio_sig_map.h"
 
 #include "jhs_recv_task.h"
+#include "jhs_frame_decoder.h"
+#include "jhs_rmt_encoder.h"
+#include "jhs_headless.h"
 #include "esp32-hal.h"
 
-#include <sstream>
-#include <iomanip>
+#include <cmath>
 
 static const char *TAG = "JHSClimate";
 
@@ -16,24 +20,33 @@ namespace esphome
 {
 namespace JHSClimate
 {
-static std::string bytes_to_hex2(std::vector<uint8_t> bytes)
-{
-    std::stringstream ss;
-    for (auto b : bytes)
-    {
-        ss << std::hex << std::setfill('0') << std::setw(2) << (int)b;
-    }
-    return ss.str();
-}
-
 void JHSClimate::setup()
 {
     ESP_LOGI(TAG, "Setting up JHSClimate...");
     this->setup_rmt();
+    // the routes connect the RX pins to the loopback signals, which the receive ISR falls back to on a queue overflow,
+    // so they have to exist before the interrupts are attached
+    this->setup_passthrough();
     jhs_recv_task_config recv_config = {
         .ac_rx_pin = this->ac_rx_pin_->get_pin(),
-        .panel_rx_pin = this->panel_rx_pin_->get_pin()};
+        .panel_rx_pin = this->is_headless() ? -1 : this->panel_rx_pin_->get_pin(),
+        .ac_tx_pin = this->ac_tx_pin_->get_pin(),
+        .panel_tx_pin = this->is_headless() ? -1 : this->panel_tx_pin_->get_pin(),
+        .passthrough_fallback = this->passthrough_};
     start_jhs_climate_recv_task(recv_config);
+    this->setup_thermostat();
+    this->setup_runtime();
+    this->setup_history();
+    if (this->is_headless())
+    {
+        // there is no panel, send the keepalives ourselves
+        jhs_headless_config headless_config = {
+            .ac_tx_pin = this->ac_tx_pin_->get_pin(),
+            .keepalive_interval_us = this->keepalive_interval_ * 1000};
+        start_jhs_headless(headless_config);
+        ESP_LOGI(TAG, "JHSClimate setup complete (headless)");
+        return;
+    }
     ESP_LOGI(TAG, "JHSClimate setup complete");
 
     // send hello packet to panel
@@ -41,7 +54,7 @@ void JHSClimate::setup()
     hello_packet.beep_amount = 3;
     hello_packet.beep_length = 1;
     hello_packet.set_display("dd");
-    this->send_rmt_data(this->rmt_panel_tx, hello_packet.to_wire_format());
+    this->send_panel_frame(hello_packet.to_wire_format());
     // auto ota = esphome::App.get_component<ota::OTAComponent>("ota");
     // OTAComponent->add_on_state_callback([this](esphome::ota::OTAState state, float progress, uint8_t error) {
     //   if (state == esphome::ota::OTA_IN_PROGRESS) {
@@ -57,15 +70,27 @@ void JHSClimate::setup()
 
 }
 
-void JHSClimate::setup_rmt()
+// Clocks the RMT channel driving the pin from the 1 MHz REF_TICK, which the power manager keeps
+// constant, instead of the APB clock which is scaled together with the CPU. Returns the tick in ns.
+static float rmt_use_ref_tick(int pin)
 {
+    int channel = GPIO.func_out_sel_cfg[pin].func_sel - RMT_SIG_OUT0_IDX;
+    RMT.conf_ch[channel].conf1.ref_always_on = 0;
+    RMT.conf_ch[channel].conf0.div_cnt = 1;
+    return 1000;
+}
 
-    this->rmt_panel_tx = rmtInit(this->panel_tx_pin_->get_pin(), true, RMT_MEM_192);
-    this->rmt_panel_tx_tick = rmtSetTick(this->rmt_panel_tx, 2500); // papieska wartość
-    ESP_LOGI(TAG, "RMT panel tx tick: %f", this->rmt_panel_tx_tick);
+void JHSClimate::setup_rmt()
+{
+    if (!this->is_headless())
+    {
+        this->rmt_panel_tx = rmtInit(this->panel_tx_pin_->get_pin(), true, RMT_MEM_192);
+        this->rmt_panel_tx_tick = rmt_use_ref_tick(this->panel_tx_pin_->get_pin());
+        ESP_LOGI(TAG, "RMT panel tx tick: %f", this->rmt_panel_tx_tick);
+    }
 
     this->rmt_ac_tx = rmtInit(this->ac_tx_pin_->get_pin(), true, RMT_MEM_192);
-    this->rmt_ac_tx_tick = rmtSetTick(this->rmt_ac_tx, 2500); // papieska wartość
+    this->rmt_ac_tx_tick = rmt_use_ref_tick(this->ac_tx_pin_->get_pin());
     ESP_LOGI(TAG, "RMT ac tx tick: %f", this->rmt_ac_tx_tick);
 
     // ugly hack to set all RMT channels to high on idle
@@ -77,18 +102,191 @@ void JHSClimate::setup_rmt()
     ESP_LOGI(TAG, "RMT initialized");
 }
 
+void JHSClimate::setup_passthrough()
+{
+    if (!this->passthrough_)
+        return;
+    this->ac_to_panel_route.setup(this->ac_rx_pin_->get_pin(), this->panel_tx_pin_->get_pin(), JHS_AC_TO_PANEL_SIGNAL);
+    this->panel_to_ac_route.setup(this->panel_rx_pin_->get_pin(), this->ac_tx_pin_->get_pin(), JHS_PANEL_TO_AC_SIGNAL);
+    ESP_LOGI(TAG, "Passthrough initialized");
+}
+
+void JHSClimate::setup_thermostat()
+{
+    if (this->room_sensor_ == nullptr)
+        return;
+    this->room_sensor_->add_on_state_callback([this](float temperature) {
+        this->current_temperature = temperature;
+        this->run_thermostat();
+        this->publish_state();
+    });
+    if (this->room_sensor_->has_state())
+    {
+        this->current_temperature = this->room_sensor_->state;
+    }
+    // the room target only comes from Home Assistant, so keep regulating with the last one after a reboot, without
+    // one the first frame from the AC sets it to the AC setpoint
+    auto restored = this->restore_state_();
+    if (restored.has_value() && std::isfinite(restored->target_temperature))
+    {
+        this->target_temperature = restored->target_temperature;
+        ESP_LOGI(TAG, "Restored the thermostat target: %.1f", this->target_temperature);
+    }
+}
+
+void JHSClimate::run_thermostat()
+{
+    if (!std::isfinite(this->current_temperature) || !std::isfinite(this->target_temperature))
+        return;
+    if (this->mode != esphome::climate::CLIMATE_MODE_COOL)
+    {
+        this->thermostat.reset();
+        return;
+    }
+    int setpoint = this->thermostat.update(this->current_temperature, this->target_temperature, esphome::millis());
+    if (setpoint < 0)
+        return;
+    this->ac_setpoint = setpoint;
+    if (setpoint != this->ac_reported_setpoint && this->steps_left_to_adjust_temp == 0)
+    {
+        ESP_LOGD(TAG, "Thermostat: room %.1f, target %.1f, setting AC to %d", this->current_temperature, this->target_temperature, setpoint);
+        this->steps_left_to_adjust_temp = 24;
+    }
+}
+
+void JHSClimate::setup_runtime()
+{
+    this->runtime_pref = global_preferences->make_preference<JHSRuntimeTotals>(this->get_object_id_hash() ^ RUNTIME_PREF_HASH);
+    if (this->runtime_pref.load(&this->runtime.get_totals()))
+    {
+        ESP_LOGI(TAG, "Restored runtime totals, %u water full events", this->runtime.get_water_full_events());
+    }
+    this->publish_runtime();
+}
+
+void JHSClimate::setup_history()
+{
+    if (this->history_size_ == 0)
+        return;
+    this->history.init(this->history_size_);
+#ifdef USE_JHS_HISTORY
+    this->web_server_base_->init();
+    this->web_server_base_->add_handler(new JHSHistoryHandler(&this->history));
+#endif
+}
+
+void JHSClimate::publish_runtime()
+{
+    for (uint8_t i = 0; i < JHS_RUNTIME_COUNTERS; i++)
+    {
+        if (this->runtime_sensors[i] != nullptr)
+            this->runtime_sensors[i]->publish_state(this->runtime.get_hours((JHSRuntimeCounter)i));
+    }
+    if (this->water_full_events_sensor != nullptr)
+        this->water_full_events_sensor->publish_state(this->runtime.get_water_full_events());
+}
+
+void JHSClimate::save_runtime()
+{
+    this->runtime_pref.save(&this->runtime.get_totals());
+}
+
+void JHSClimate::on_shutdown()
+{
+    this->save_runtime();
+}
+
+void JHSClimate::export_frame(JHSTelemetryFrameType type, const uint8_t *frame, size_t len)
+{
+    if (!this->telemetry_)
+        return;
+    unsigned long start = jhs_time_us();
+    if (this->telemetry.add(type, frame, len, esphome::millis()))
+    {
+        this->telemetry_encoded++;
+    }
+    else
+    {
+        // the datagram is full before it is due, the rate limit wins
+        this->telemetry_dropped++;
+    }
+    this->telemetry_time_us += jhs_time_us() - start;
+}
+
+void JHSClimate::flush_telemetry()
+{
+    if (this->telemetry.empty())
+        return;
+    if (wifi::global_wifi_component->is_connected())
+    {
+        this->telemetry_udp.beginPacket(this->telemetry_host, this->telemetry_port);
+        this->telemetry_udp.write(this->telemetry.data(), this->telemetry.size());
+        this->telemetry_udp.endPacket();
+        this->telemetry_frames += this->telemetry.get_count();
+        this->telemetry_bytes += this->telemetry.size();
+    }
+    else
+    {
+        this->telemetry_dropped += this->telemetry.get_count();
+    }
+    this->telemetry.reset(++this->telemetry_sequence);
+}
+
+void JHSClimate::report_telemetry()
+{
+    // frames are counted as sent or dropped when their datagram is flushed, encoding time when they are added
+    if (this->telemetry_frames > 0 && this->telemetry_encoded > 0)
+    {
+        ESP_LOGD(TAG, "Telemetry: %u frames sent, %u dropped, %.1f bytes per frame sent, %.2f us per frame encoded",
+                 this->telemetry_frames, this->telemetry_dropped,
+                 (float)this->telemetry_bytes / this->telemetry_frames, (float)this->telemetry_time_us / this->telemetry_encoded);
+    }
+    else if (this->telemetry_dropped > 0)
+    {
+        ESP_LOGD(TAG, "Telemetry: no frames sent, %u dropped", this->telemetry_dropped);
+    }
+    this->telemetry_frames = 0;
+    this->telemetry_encoded = 0;
+    this->telemetry_dropped = 0;
+    this->telemetry_bytes = 0;
+    this->telemetry_time_us = 0;
+}
+
+void JHSClimate::report_health()
+{
+    JHSHealthStats health = this->get_health();
+    uint32_t decoded = health.ac_frames_valid + health.ac_frames_repaired;
+    uint32_t total = decoded + health.ac_frames_unrecoverable;
+    ESP_LOGD(TAG, "AC frames: %u valid, %u repaired, %u unrecoverable (%.2f%% decoded)",
+             health.ac_frames_valid, health.ac_frames_repaired, health.ac_frames_unrecoverable,
+             total > 0 ? 100.0f * decoded / total : 100.0f);
+    ESP_LOGD(TAG, "Health: %u us worst frame processing time, %u queue overflows, %u convergence failures",
+             health.max_frame_processing_us, health.queue_overflows, health.convergence_failures);
+    // every report covers the interval since the previous one
+    this->health = JHSHealthStats();
+    this->reported_queue_overflows += health.queue_overflows;
+}
+
 void JHSClimate::control(const esphome::climate::ClimateCall &call)
 {
     if (call.get_target_temperature().has_value())
     {
         this->target_temperature = call.get_target_temperature().value();
-        this->steps_left_to_adjust_temp = 24;
+        if (this->room_sensor_ == nullptr)
+        {
+            this->ac_setpoint = this->target_temperature;
+            this->steps_left_to_adjust_temp = 24;
+        }
     }
     if (call.get_mode().has_value())
     {
         this->mode = call.get_mode().value();
         this->steps_left_to_adjust_mode = 8;
     }
+    if (this->room_sensor_ != nullptr)
+    {
+        this->run_thermostat();
+    }
     if (call.get_fan_mode().has_value())
     {
         this->fan_mode = call.get_fan_mode().value();
@@ -130,12 +328,106 @@ void JHSClimate::dump_config()
     LOG_PIN("  Panel RX Pin: ", this->panel_rx_pin_);
     ESP_LOGCONFIG(TAG, "  RMT panel tx tick: %f", this->rmt_panel_tx_tick);
     ESP_LOGCONFIG(TAG, "  RMT ac tx tick: %f", this->rmt_ac_tx_tick);
+    ESP_LOGCONFIG(TAG, "  Passthrough: %s", YESNO(this->passthrough_));
+    if (this->is_headless())
+    {
+        ESP_LOGCONFIG(TAG, "  Headless, keepalive every %u ms", this->keepalive_interval_);
+    }
+    if (this->telemetry_)
+    {
+        ESP_LOGCONFIG(TAG, "  Telemetry: %s:%u every %u ms", this->telemetry_host.toString().c_str(), this->telemetry_port, this->telemetry_interval);
+    }
+    if (this->history.is_enabled())
+    {
+        ESP_LOGCONFIG(TAG, "  History: %u bytes", this->history.get_size());
+    }
+    if (this->room_sensor_ != nullptr)
+    {
+        ESP_LOGCONFIG(TAG, "  Thermostat: %s", this->thermostat.get_type() == JHS_THERMOSTAT_PID ? "pid" : "hysteresis");
+        ESP_LOGCONFIG(TAG, "  Thermostat hysteresis: %.1f", this->thermostat.get_hysteresis());
+    }
+    ESP_LOGCONFIG(TAG, "  Wifi icon: %s", YESNO(this->ac_rewrite.stage<JHSWifiIconRewrite>().enabled));
+    ESP_LOGCONFIG(TAG, "  Beep policy: %s", jhs_beep_policy_to_string(this->ac_rewrite.stage<JHSBeepRewrite>().policy));
+    ESP_LOGCONFIG(TAG, "  Display override: %s", YESNO(this->ac_rewrite.stage<JHSDisplayRewrite>().enabled));
 }
 
 void JHSClimate::loop()
 {
+    // the loop drains the queues again, a fallback still waiting for a frame boundary would cut our own frames
+    jhs_rx_cancel_fallback();
     this->recv_from_ac();
     this->recv_from_panel();
+    this->update_routes();
+
+    uint32_t now = esphome::millis();
+    if (now - this->last_runtime_publish > RUNTIME_PUBLISH_INTERVAL)
+    {
+        this->publish_runtime();
+        this->last_runtime_publish = now;
+    }
+    if (now - this->last_runtime_save > RUNTIME_SAVE_INTERVAL)
+    {
+        this->save_runtime();
+        this->last_runtime_save = now;
+    }
+
+    if (this->telemetry_ && now - this->last_telemetry_flush >= this->telemetry_interval)
+    {
+        this->flush_telemetry();
+        this->last_telemetry_flush = now;
+    }
+
+    if (esphome::millis() - this->last_stats_report > STATS_REPORT_INTERVAL)
+    {
+        this->report_pm_locks();
+        if (this->telemetry_)
+        {
+            this->report_telemetry();
+        }
+        this->report_health();
+        if (this->history.is_enabled())
+        {
+            ESP_LOGD(TAG, "History: %u records in %u of %u bytes", this->history.get_records(), this->history.get_used(), this->history.get_size());
+        }
+        if (this->is_headless())
+        {
+            ESP_LOGD(TAG, "Headless: %u frames sent, max jitter %u us", jhs_headless_frames_sent(), jhs_headless_max_jitter_us());
+        }
+        this->last_stats_report = esphome::millis();
+    }
+}
+
+void JHSClimate::update_routes()
+{
+    // button presses are injected on the AC line, so it can only be passed through while we are not adjusting
+    this->panel_to_ac_route.request(!this->is_adjusting());
+
+    if (this->ac_to_panel_route.update(jhs_ac_rx_idle_time()))
+    {
+        ESP_LOGD(TAG, "AC->panel switched to %s", this->ac_to_panel_route.is_passthrough() ? "passthrough" : "software");
+    }
+    if (this->panel_to_ac_route.update(jhs_panel_rx_idle_time()))
+    {
+        ESP_LOGD(TAG, "Panel->AC switched to %s", this->panel_to_ac_route.is_passthrough() ? "passthrough" : "software");
+    }
+    if (!this->pending_panel_frame.empty() && !this->ac_to_panel_route.is_passthrough() &&
+        this->send_rmt_data(this->rmt_panel_tx, this->pending_panel_frame))
+    {
+        this->pending_panel_frame.clear();
+    }
+}
+
+void JHSClimate::send_panel_frame(std::vector<uint8_t> data)
+{
+    if (!this->ac_to_panel_route.is_passthrough())
+    {
+        this->send_rmt_data(this->rmt_panel_tx, data);
+        return;
+    }
+    // the panel TX pin is looped back to the AC RX pin, switch to software on the next frame boundary
+    ESP_LOGV(TAG, "Panel frame queued until the AC->panel line leaves passthrough");
+    this->pending_panel_frame = data;
+    this->ac_to_panel_route.request(false);
 }
 
 
@@ -144,6 +436,7 @@ void JHSClimate::recv_from_panel()
     uint8_t packet[JHS_PANEL_PACKET_SIZE];
     while (xQueueReceive(panel_rx_queue, &packet, 0))
     {
+        this->export_frame(JHS_TELEMETRY_PANEL, packet, JHS_PANEL_PACKET_SIZE);
         std::vector<uint8_t> packet_vector(packet, packet + JHS_PANEL_PACKET_SIZE);
 
         if (memcmp(packet, &KEEPALIVE_PACKET, JHS_PANEL_PACKET_SIZE) == 0)
@@ -187,12 +480,12 @@ void JHSClimate::recv_from_panel()
             hello_packet.power = 0;
             hello_packet.cool = 1;
             hello_packet.set_display("dd");
-            this->send_rmt_data(this->rmt_panel_tx, hello_packet.to_wire_format());
+            this->send_panel_frame(hello_packet.to_wire_format());
             continue;
         }
         else
         {
-            ESP_LOGI(TAG, "Received unknown packet from panel: %s", bytes_to_hex2(packet_vector).c_str());
+            ESP_LOGI(TAG, "Received unknown packet from panel: %s", bytes_to_hex(packet, JHS_PANEL_PACKET_SIZE).c_str());
         }
         this->send_rmt_data(this->rmt_ac_tx, packet_vector);
     }
@@ -205,65 +498,135 @@ bool JHSClimate::is_adjusting()
 
 void JHSClimate::recv_from_ac()
 {
-    uint8_t packet[JHS_AC_PACKET_SIZE];
+    jhs_ac_rx_frame rx_frame;
 
-    while (xQueueReceive(ac_rx_queue, &packet, 0))
+    while (xQueueReceive(ac_rx_queue, &rx_frame, 0))
     {
-        std::vector<uint8_t> packet_vector(packet, packet + JHS_AC_PACKET_SIZE);
-        esphome::optional<JHSAcPacket> packet_optional = JHSAcPacket::parse(packet_vector);
-        if (!packet_optional)
+        unsigned long start = this->processing_clock_us();
+        this->process_ac_frame(rx_frame);
+        unsigned long elapsed = this->processing_clock_us() - start;
+        if (elapsed > this->health.max_frame_processing_us)
         {
-            ESP_LOGV(TAG, "Received invalid packet from AC");
-            continue;
+            this->health.max_frame_processing_us = elapsed;
         }
-        JHSAcPacket packet = *packet_optional;
-        ESP_LOGVV(TAG, "Received new packet from AC: %s", packet.to_string());
+    }
+}
 
+void JHSClimate::process_ac_frame(const jhs_ac_rx_frame &rx_frame)
+{
+    uint8_t frame[JHS_AC_PACKET_SIZE];
 
-        // Modify the packet 
-        packet.wifi = !wifi::global_wifi_component->is_connected();
-        if (is_adjusting()){
-            packet.beep_amount = 0;
-            packet.beep_length = 0;
-        }
+    switch (jhs_decode_ac_frame(rx_frame, frame))
+    {
+    case JHS_DECODE_VALID:
+        this->health.ac_frames_valid++;
+        break;
+    case JHS_DECODE_REPAIRED:
+        ESP_LOGV(TAG, "Repaired corrupted packet from AC");
+        this->health.ac_frames_repaired++;
+        break;
+    case JHS_DECODE_UNRECOVERABLE:
+        ESP_LOGV(TAG, "Received unrecoverable packet from AC");
+        this->health.ac_frames_unrecoverable++;
+        return;
+    }
+    this->export_frame(JHS_TELEMETRY_AC, frame, JHS_AC_PACKET_SIZE - 1);
+    std::vector<uint8_t> packet_vector(frame, frame + JHS_AC_PACKET_SIZE);
+    esphome::optional<JHSAcPacket> packet_optional = JHSAcPacket::parse(packet_vector);
+    if (!packet_optional)
+    {
+        ESP_LOGV(TAG, "Received invalid packet from AC");
+        return;
+    }
+    JHSAcPacket packet = *packet_optional;
+    ESP_LOGVV(TAG, "Received new packet from AC: %s", packet.to_string().c_str());
 
-        esphome::climate::ClimateMode mode_from_packet = esphome::climate::CLIMATE_MODE_OFF;
-        if (packet.cool)
-        {
-            mode_from_packet = esphome::climate::CLIMATE_MODE_COOL;
-        }
-        else if (packet.heat)
-        {
-            mode_from_packet = esphome::climate::CLIMATE_MODE_HEAT;
-        }
-        else if (packet.fan)
-        {
-            mode_from_packet = esphome::climate::CLIMATE_MODE_FAN_ONLY;
-        }
-        else if (packet.dehum)
-        {
-            mode_from_packet = esphome::climate::CLIMATE_MODE_DRY;
-        }
-        esphome::climate::ClimateFanMode fan_from_packet = esphome::climate::CLIMATE_FAN_LOW;
-        if (packet.fan_high)
+    bool rewritten = this->rewrite_ac_frame(packet_vector.data());
+    this->ac_to_panel_route.request(!rewritten && this->pending_panel_frame.empty());
+
+    esphome::climate::ClimateMode mode_from_packet = esphome::climate::CLIMATE_MODE_OFF;
+    if (packet.cool)
+    {
+        mode_from_packet = esphome::climate::CLIMATE_MODE_COOL;
+    }
+    else if (packet.heat)
+    {
+        mode_from_packet = esphome::climate::CLIMATE_MODE_HEAT;
+    }
+    else if (packet.fan)
+    {
+        mode_from_packet = esphome::climate::CLIMATE_MODE_FAN_ONLY;
+    }
+    else if (packet.dehum)
+    {
+        mode_from_packet = esphome::climate::CLIMATE_MODE_DRY;
+    }
+    esphome::climate::ClimateFanMode fan_from_packet = esphome::climate::CLIMATE_FAN_LOW;
+    if (packet.fan_high)
+    {
+        fan_from_packet = esphome::climate::CLIMATE_FAN_HIGH;
+    }
+    if (packet.fan_low)
+    {
+        fan_from_packet = esphome::climate::CLIMATE_FAN_LOW;
+    }
+    esphome::climate::ClimatePreset preset_from_packet = esphome::climate::CLIMATE_PRESET_NONE;
+    if (packet.sleep) preset_from_packet = esphome::climate::CLIMATE_PRESET_SLEEP;
+    if (packet.cool && packet.get_temp() > 0)
+    {
+        this->ac_reported_setpoint = packet.get_temp();
+    }
+    this->runtime.update(packet, this->water_full, esphome::millis());
+    this->history.record(jhs_history_flags(packet, this->water_full, this->is_adjusting()), packet.get_temp(), esp_timer_get_time() / 1000000);
+
+    JHSAcSnapshot snapshot;
+    snapshot.valid = true;
+    snapshot.packet = packet;
+    snapshot.frame_time = esphome::millis();
+    snapshot.mode = mode_from_packet;
+    snapshot.fan_mode = fan_from_packet;
+    snapshot.preset = preset_from_packet;
+    snapshot.display_temp = packet.get_temp();
+    snapshot.water_full = this->water_full;
+    snapshot.adjusting = this->is_adjusting();
+    this->snapshot_.write(snapshot);
+
+    if (!this->is_adjusting())
+    {
+        // if we are not adjusting anything we can copy the state from the packet to the climate
+
+        // keeps the requested state while the AC may still be applying the last presses
+        bool settling = false;
+        if (this->verify_adjustment && ++this->settle_frames < CONVERGENCE_SETTLE_FRAMES)
         {
-            fan_from_packet = esphome::climate::CLIMATE_FAN_HIGH;
+            settling = true;
         }
-        if (packet.fan_low)
+        else if (this->verify_adjustment)
         {
-            fan_from_packet = esphome::climate::CLIMATE_FAN_LOW;
+            // an adjustment ended and every press had time to show up, check that the AC ended up where we wanted it,
+            // a press which showed up a frame late may have been repeated and overshot
+            this->verify_adjustment = false;
+            // a setpoint asked for before the AC left cool mode was not part of this adjustment
+            bool temp_reached = !this->verify_temp || !packet.cool || this->ac_setpoint == packet.get_temp();
+            this->verify_temp = false;
+            // the fan and sleep icons mean nothing while the AC is off
+            bool fan_reached = mode_from_packet == esphome::climate::CLIMATE_MODE_OFF ||
+                               (this->fan_mode == fan_from_packet && this->preset == preset_from_packet);
+            if (this->mode != mode_from_packet || !fan_reached || !temp_reached)
+            {
+                ESP_LOGW(TAG, "Adjustment did not converge, AC state: %s", packet.to_string().c_str());
+                this->health.convergence_failures++;
+            }
         }
-        esphome::climate::ClimatePreset preset_from_packet = esphome::climate::CLIMATE_PRESET_NONE;
-        if (packet.sleep) preset_from_packet = esphome::climate::CLIMATE_PRESET_SLEEP;
 
-        if (!this->is_adjusting())
+        bool did_change = false;
+        // with a room sensor the target belongs to the on-device thermostat and the display shows its AC setpoint
+        if (this->room_sensor_ == nullptr && !settling)
         {
-            // if we are not adjusting anything we can copy the state from the packet to the climate
-
-            bool did_change = false;
             if (packet.get_temp() > 0 && this->target_temperature != packet.get_temp() && packet.cool)
             {
                 this->target_temperature = packet.get_temp();
+                this->ac_setpoint = packet.get_temp();
                 did_change = true;
             }
             if (this->current_temperature != packet.get_temp())
@@ -271,182 +634,235 @@ void JHSClimate::recv_from_ac()
                 this->current_temperature = packet.get_temp(); // Fake the current temperature
                 did_change = true;
             }
-            if (this->mode != mode_from_packet)
-            {
-                this->mode = mode_from_packet;
-                did_change = true;
-            }
-            if (this->fan_mode != fan_from_packet)
-            {
-                this->fan_mode = fan_from_packet;
-                did_change = true;
-            }
-            if (this->preset != preset_from_packet)
-            {
-                this->preset = preset_from_packet;
-                did_change = true;
-            }
-            
-            if (did_change)
-            {
-                this->publish_state();
-            }
-            if (this->water_full != packet.water_full)
-            {
-                if (packet.water_full){
-                    last_water_full = esphome::millis();
-                    this->water_full = true;
+        }
+        else if (!settling && !std::isfinite(this->target_temperature) && packet.get_temp() > 0 && packet.cool)
+        {
+            // no target was restored, start from the setpoint the AC was left at
+            this->target_temperature = packet.get_temp();
+            did_change = true;
+        }
+        if (this->mode != mode_from_packet && !settling)
+        {
+            this->mode = mode_from_packet;
+            did_change = true;
+        }
+        if (this->fan_mode != fan_from_packet && !settling)
+        {
+            this->fan_mode = fan_from_packet;
+            did_change = true;
+        }
+        if (this->preset != preset_from_packet && !settling)
+        {
+            this->preset = preset_from_packet;
+            did_change = true;
+        }
+        
+        if (did_change)
+        {
+            this->publish_state();
+        }
+        if (this->water_full != packet.water_full)
+        {
+            if (packet.water_full){
+                last_water_full = esphome::millis();
+                this->water_full = true;
+            }else{
+                if (esphome::millis() - last_water_full > WATER_FULL_INTERVAL){
+                    this->water_full = false;
                 }else{
-                    if (esphome::millis() - last_water_full > WATER_FULL_INTERVAL){
-                        this->water_full = false;
-                    }else{
-                        this->water_full = true;
-                    }
-                    last_water_full = esphome::millis();
+                    this->water_full = true;
                 }
-                this->water_full_sensor->publish_state(this->water_full);
+                last_water_full = esphome::millis();
             }
+            this->water_full_sensor->publish_state(this->water_full);
         }
-        else
+    }
+    else if (this->panel_to_ac_route.is_passthrough())
+    {
+        ESP_LOGVV(TAG, "Waiting for the panel->AC line to switch to software before pressing buttons");
+    }
+    else if (this->is_headless() && !jhs_headless_ready())
+    {
+        ESP_LOGVV(TAG, "Waiting for the previous button press to replace a keepalive");
+    }
+    else
+    {
+        if (esphome::millis() - last_adjustment < ADJUSTMENT_INTERVAL)
         {
-            if (esphome::millis() - last_adjustment < ADJUSTMENT_INTERVAL)
-            {
-                continue;
-            }
-            last_adjustment = esphome::millis();
-            // we are adjusting
-            if (this->steps_left_to_adjust_temp > 0)
+            return;
+        }
+        last_adjustment = esphome::millis();
+        // we are adjusting
+        if (this->steps_left_to_adjust_temp > 0)
+        {
+            this->verify_temp = true;
+            if (this->ac_setpoint != packet.get_temp())
             {
-                if (this->target_temperature != packet.get_temp())
+                auto packet_to_send = BUTTON_LOWER_TEMP;
+                if (this->ac_setpoint > packet.get_temp())
                 {
-                    auto packet_to_send = BUTTON_LOWER_TEMP;
-                    if (this->target_temperature > packet.get_temp())
-                    {
-                        packet_to_send = BUTTON_HIGHER_TEMP;
-                        ESP_LOGD(TAG, "Sending BUTTON_HIGHER_TEMP packet to AC");
-                    }
-                    else
-                    {
-                        ESP_LOGD(TAG, "Sending BUTTON_LOWER_TEMP packet to AC");
-                    }
-                    // create a vector from BUTTON_UP, which is an std::array
-                    std::vector<uint8_t> packet_vector(packet_to_send.begin(), packet_to_send.end());
-
-                    this->send_rmt_data(this->rmt_ac_tx, packet_vector);
-                    this->steps_left_to_adjust_temp--;
+                    packet_to_send = BUTTON_HIGHER_TEMP;
+                    ESP_LOGD(TAG, "Sending BUTTON_HIGHER_TEMP packet to AC");
                 }
                 else
                 {
-                    this->steps_left_to_adjust_temp = 0;
+                    ESP_LOGD(TAG, "Sending BUTTON_LOWER_TEMP packet to AC");
+                }
+                // create a vector from BUTTON_UP, which is an std::array
+                std::vector<uint8_t> packet_vector(packet_to_send.begin(), packet_to_send.end());
+
+                if (this->send_rmt_data(this->rmt_ac_tx, packet_vector))
+                {
+                    this->steps_left_to_adjust_temp--;
                 }
             }
-            if (this->steps_left_to_adjust_fan > 0)
+            else
             {
-                if (this->fan_mode != fan_from_packet)
-                {
-                    auto packet_to_send = BUTTON_FAN;
+                this->steps_left_to_adjust_temp = 0;
+            }
+        }
+        if (this->steps_left_to_adjust_fan > 0)
+        {
+            if (this->fan_mode != fan_from_packet)
+            {
+                auto packet_to_send = BUTTON_FAN;
 
-                    // create a vector from BUTTON_FAN, which is an std::array
-                    std::vector<uint8_t> packet_vector(packet_to_send.begin(), packet_to_send.end());
-                    ESP_LOGD(TAG, "Sending BUTTON_FAN packet to AC");
-                    this->send_rmt_data(this->rmt_ac_tx, packet_vector);
-                    this->steps_left_to_adjust_fan--;
-                }
-                else
+                // create a vector from BUTTON_FAN, which is an std::array
+                std::vector<uint8_t> packet_vector(packet_to_send.begin(), packet_to_send.end());
+                ESP_LOGD(TAG, "Sending BUTTON_FAN packet to AC");
+                if (this->send_rmt_data(this->rmt_ac_tx, packet_vector))
                 {
-                    this->steps_left_to_adjust_fan = 0;
+                    this->steps_left_to_adjust_fan--;
                 }
             }
+            else
+            {
+                this->steps_left_to_adjust_fan = 0;
+            }
+        }
+        if (this->adjust_preset)
+        {
             if (this->preset != preset_from_packet)
             {
                 auto packet_to_send = BUTTON_SLEEP;
                 // create a vector from BUTTON_SLEEP, which is an std::array
                 std::vector<uint8_t> packet_vector(packet_to_send.begin(), packet_to_send.end());
                 ESP_LOGD(TAG, "Sending BUTTON_SLEEP packet to AC");
-                this->send_rmt_data(this->rmt_ac_tx, packet_vector);
+                if (this->send_rmt_data(this->rmt_ac_tx, packet_vector))
+                    this->adjust_preset = false;
+            }
+            else
+            {
                 this->adjust_preset = false;
             }
-            if (this->steps_left_to_adjust_mode > 0)
+        }
+        if (this->steps_left_to_adjust_mode > 0)
+        {
+            if (this->mode != mode_from_packet)
             {
-                if (this->mode != mode_from_packet)
+                auto packet_to_send = BUTTON_MODE;
+                if (this->mode == esphome::climate::ClimateMode::CLIMATE_MODE_OFF || mode_from_packet == esphome::climate::CLIMATE_MODE_OFF)
                 {
-                    auto packet_to_send = BUTTON_MODE;
-                    if (this->mode == esphome::climate::ClimateMode::CLIMATE_MODE_OFF || mode_from_packet == esphome::climate::CLIMATE_MODE_OFF)
-                    {
-                        packet_to_send = BUTTON_ON;
-                        ESP_LOGD(TAG, "Sending BUTTON_ON packet to AC");
-                    }
-                    else
-                    {
-                        ESP_LOGD(TAG, "Sending BUTTON_MODE packet to AC");
-                    }
-                    // create a vector from BUTTON_MODE, which is an std::array
-                    std::vector<uint8_t> packet_vector(packet_to_send.begin(), packet_to_send.end());
-
-                    this->send_rmt_data(this->rmt_ac_tx, packet_vector);
-                    this->steps_left_to_adjust_mode--;
+                    packet_to_send = BUTTON_ON;
+                    ESP_LOGD(TAG, "Sending BUTTON_ON packet to AC");
                 }
                 else
                 {
-                    this->steps_left_to_adjust_mode = 0;
+                    ESP_LOGD(TAG, "Sending BUTTON_MODE packet to AC");
                 }
-            }
+                // create a vector from BUTTON_MODE, which is an std::array
+                std::vector<uint8_t> packet_vector(packet_to_send.begin(), packet_to_send.end());
 
+                if (this->send_rmt_data(this->rmt_ac_tx, packet_vector))
+                {
+                    this->steps_left_to_adjust_mode--;
+                }
+            }
+            else
+            {
+                this->steps_left_to_adjust_mode = 0;
+            }
+        }
+        if (!this->is_adjusting())
+        {
+            // the last press was sent or nothing was left to press, check the result once it had time to show up.
+            // The frames still queued were sent by the AC before the press, after a stall they would settle it at once
+            this->verify_adjustment = true;
+            this->settle_frames = -(int)uxQueueMessagesWaiting(ac_rx_queue);
         }
-        this->send_rmt_data(this->rmt_panel_tx, packet.to_wire_format());
+
     }
+    this->send_rmt_data(this->rmt_panel_tx, packet_vector);
 }
 
-
-void JHSClimate::send_rmt_data(rmt_obj_t *rmt, std::vector<uint8_t> data)
+bool JHSClimate::rewrite_ac_frame(uint8_t *frame)
 {
-    ESP_LOGVV(TAG, "Sending RMT data: %s", bytes_to_hex2(data).c_str());
-
-    std::vector<rmt_data_t> rmt_data_to_send = {};
-    rmt_data_to_send.reserve((data.size() * 8) + 2); // 8 bits per byte + 2 bits for start/stop
-    rmt_data_t leadin;
-    leadin.level0 = 0;
-    leadin.duration0 = 1800;
-    leadin.level1 = 1;
-    leadin.duration1 = 900;
-    rmt_data_to_send.push_back(leadin);
-    for (size_t i = 0; i < data.size() * 8; i++)
+    uint8_t original[JHS_AC_PACKET_SIZE];
+    memcpy(original, frame, JHS_AC_PACKET_SIZE);
+    // esp_timer rather than the cycle counter, which changes its rate with the CPU clock under DFS
+    unsigned long start = jhs_time_us();
+    JHSRewriteContext ctx = {
+        .wifi_connected = wifi::global_wifi_component->is_connected(),
+        .adjusting = this->is_adjusting()};
+    this->ac_rewrite.apply(frame, ctx);
+    uint32_t elapsed = jhs_time_us() - start;
+
+    this->rewrite_time_us_total += elapsed;
+    if (elapsed > this->rewrite_time_us_max)
+        this->rewrite_time_us_max = elapsed;
+    if (++this->rewrite_frames >= REWRITE_STATS_INTERVAL)
     {
-        uint8_t bit = (data[i / 8] >> (7 - (i % 8))) & 1;
+        ESP_LOGD(TAG, "AC frame rewrite: avg %.2f us, max %u us per frame over %u frames",
+                 (float)this->rewrite_time_us_total / this->rewrite_frames, this->rewrite_time_us_max, this->rewrite_frames);
+        this->rewrite_frames = 0;
+        this->rewrite_time_us_total = 0;
+        this->rewrite_time_us_max = 0;
+    }
+    return memcmp(original, frame, JHS_AC_PACKET_SIZE) != 0;
+}
 
-        if (bit)
-        {
-            rmt_data_t bit1;
-            bit1.level0 = 0;
-            bit1.duration0 = 100;
-            bit1.level1 = 1;
-            bit1.duration1 = 300;
-            rmt_data_to_send.push_back(bit1);
-        }
-        else
-        {
-            rmt_data_t bit0;
-            bit0.level0 = 0;
-            bit0.duration0 = 100;
-            bit0.level1 = 1;
-            bit0.duration1 = 100;
-            rmt_data_to_send.push_back(bit0);
-        }
+
+bool JHSClimate::send_rmt_data(rmt_obj_t *rmt, std::vector<uint8_t> data)
+{
+    if (this->is_headless())
+    {
+        // the AC line is driven by the keepalive timer and there is no panel to talk to
+        if (rmt == this->rmt_ac_tx)
+            return jhs_headless_send(data.data());
+        return false;
+    }
+    JHSPassthroughRoute &route = rmt == this->rmt_ac_tx ? this->panel_to_ac_route : this->ac_to_panel_route;
+    if (route.is_passthrough())
+    {
+        // the frame was already forwarded by the GPIO matrix
+        ESP_LOGVV(TAG, "Not sending RMT data, line is in passthrough");
+        return false;
     }
+    ESP_LOGVV(TAG, "Sending RMT data: %s", bytes_to_hex(data.data(), data.size()).c_str());
+
+    // durations are in 1 us REF_TICK ticks, see setup_rmt()
+    std::vector<rmt_data_t> rmt_data_to_send(jhs_rmt_items_for(data.size()));
+    jhs_rmt_encode(data.data(), data.size(), rmt_data_to_send.data());
+
+    uint32_t ticks = jhs_rmt_duration(rmt_data_to_send.data(), rmt_data_to_send.size());
+    float tick_ns = rmt == this->rmt_ac_tx ? this->rmt_ac_tx_tick : this->rmt_panel_tx_tick;
+    uint32_t duration_us = ticks * tick_ns / 1000;
+    // no PM lock needed, the channel runs from REF_TICK and light sleep is already blocked by the receive side
+    route.mark_tx(duration_us);
+
+    return rmtWrite(rmt, rmt_data_to_send.data(), rmt_data_to_send.size());
+}
 
-    rmt_data_t leadout;
-    leadout.level0 = 0;
-    leadout.duration0 = 100;
-    leadout.level1 = 1;
-    leadout.duration1 = 100;
-    rmt_data_to_send.push_back(leadout);
-    rmt_data_t end;
-    end.level0 = 0;
-    end.duration0 = 200;
-    end.level1 = 1;
-    end.duration1 = 200;
-    rmt_data_to_send.push_back(end);
-    rmtWrite(rmt, rmt_data_to_send.data(), rmt_data_to_send.size());
+void JHSClimate::report_pm_locks()
+{
+    uint64_t rx_held = jhs_rx_pm_lock_held_time_us();
+    uint32_t elapsed_ms = esphome::millis() - this->last_stats_report;
+    if (elapsed_ms > 0)
+    {
+        ESP_LOGD(TAG, "RX PM locks held over the last %u ms: %.1f%%", elapsed_ms,
+                 (rx_held - this->last_pm_rx_held_us) / 10.0f / elapsed_ms);
+    }
+    this->last_pm_rx_held_us = rx_held;
 }
 
 
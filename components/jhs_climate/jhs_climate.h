@@ -5,6 +5,7 @@
 #include "esphome/core/gpio.h"
 #include "esphome/components/climate/climate.h"
 #include "esphome/components/binary_sensor/binary_sensor.h"
+#include "esphome/components/sensor/sensor.h"
 #include "esphome/components/wifi/wifi_component.h"
 #include "esphome/components/ota/ota_component.h"
 #include "esphome.h"
@@ -12,6 +13,17 @@
 #include "esp32-hal-rmt.h"
 #include "soc/rmt_struct.h"
 #include "jhs_packets.h"
+#include "jhs_recv_task.h"
+#include "jhs_rewrite.h"
+#include "jhs_passthrough.h"
+#include "jhs_pm.h"
+#include "jhs_thermostat.h"
+#include "jhs_runtime.h"
+#include "jhs_telemetry.h"
+#include "jhs_history.h"
+#include "jhs_history_handler.h"
+#include "jhs_seqlock.h"
+#include <WiFiUdp.h>
 #include <vector>
 
 
@@ -20,6 +32,40 @@ namespace esphome
 namespace JHSClimate
 {
 
+///@brief Counters describing how well decoding, forwarding and adjustment hold up, cleared with every health report.
+struct JHSHealthStats
+{
+    uint32_t ac_frames_valid = 0;
+    uint32_t ac_frames_repaired = 0;
+    uint32_t ac_frames_unrecoverable = 0;
+    // frames lost because a receive queue was full, summed over both lines
+    uint32_t queue_overflows = 0;
+    // adjustments which did not reach the requested state within the settle frames after their last press
+    uint32_t convergence_failures = 0;
+    // longest time spent processing a single AC frame in the main loop
+    uint32_t max_frame_processing_us = 0;
+};
+
+///@brief The last decoded AC frame and the state derived from it, see JHSClimate::get_snapshot().
+struct JHSAcSnapshot
+{
+    // false until the first frame was received
+    bool valid = false;
+    // as sent by the AC, before any rewrite
+    JHSAcPacket packet;
+    // esphome::millis() when the frame was processed
+    uint32_t frame_time = 0;
+    esphome::climate::ClimateMode mode = esphome::climate::CLIMATE_MODE_OFF;
+    esphome::climate::ClimateFanMode fan_mode = esphome::climate::CLIMATE_FAN_LOW;
+    esphome::climate::ClimatePreset preset = esphome::climate::CLIMATE_PRESET_NONE;
+    // temperature on the display, -1 while it shows something else
+    int display_temp = -1;
+    // debounced like the water full binary sensor, updated one frame later than the packet bit
+    bool water_full = false;
+    // buttons are being pressed to reach the requested state
+    bool adjusting = false;
+};
+
 class JHSClimate : public esphome::Component, public esphome::climate::Climate
 {
 public:
@@ -31,23 +77,123 @@ public:
 
     void set_water_full_sensor(esphome::binary_sensor::BinarySensor *water_full_sensor_) { water_full_sensor  = water_full_sensor_; }
 
+    void set_passthrough(bool passthrough) { passthrough_ = passthrough; }
+    void set_keepalive_interval(uint32_t interval) { keepalive_interval_ = interval; }
+
+    // without a panel the ESP sends the keepalives to the AC itself
+    bool is_headless() { return this->panel_tx_pin_ == nullptr; }
+
+    // thermostat setters
+    void set_room_sensor(esphome::sensor::Sensor *room_sensor) { room_sensor_ = room_sensor; }
+    void set_thermostat_type(JHSThermostatType type) { thermostat.set_type(type); }
+    void set_thermostat_hysteresis(float hysteresis) { thermostat.set_hysteresis(hysteresis); }
+    void set_thermostat_pid(float kp, float ki, float kd) { thermostat.set_pid(kp, ki, kd); }
+
+    // runtime setters
+    void set_runtime_sensor(JHSRuntimeCounter counter, esphome::sensor::Sensor *sensor) { runtime_sensors[counter] = sensor; }
+    void set_water_full_events_sensor(esphome::sensor::Sensor *sensor) { water_full_events_sensor = sensor; }
+
+    void set_telemetry(const std::string &host, uint16_t port, uint32_t interval)
+    {
+        telemetry_ = telemetry_host.fromString(host.c_str());
+        telemetry_port = port;
+        telemetry_interval = interval;
+    }
+
+    void set_history_size(size_t size) { history_size_ = size; }
+#ifdef USE_JHS_HISTORY
+    void set_web_server_base(esphome::web_server_base::WebServerBase *base) { web_server_base_ = base; }
+#endif
+
+    // rewrite setters
+    void set_wifi_icon(bool enabled) { ac_rewrite.stage<JHSWifiIconRewrite>().enabled = enabled; }
+    void set_beep_policy(JHSBeepPolicy policy) { ac_rewrite.stage<JHSBeepRewrite>().policy = policy; }
+    // an empty string disables the override
+    void set_display_override(const std::string &text) { ac_rewrite.stage<JHSDisplayRewrite>().set_text(text); }
+
     // esphome handlers
     void setup() override;
     void dump_config() override;
     esphome::climate::ClimateTraits traits() override;
     void control(const esphome::climate::ClimateCall &call) override;
     void loop() override;
+    void on_shutdown() override;
+
+    ///@brief Counters since the last health report.
+    JHSHealthStats get_health() const
+    {
+        JHSHealthStats health = this->health;
+        health.queue_overflows = jhs_rx_queue_overflows() - this->reported_queue_overflows;
+        return health;
+    }
+
+    ///@brief Copy of the latest AC state. Lock free and constant time, callable from any task on either core.
+    JHSAcSnapshot get_snapshot() const { return this->snapshot_.read(); }
+    ///@brief Increments with every decoded AC frame, poll it to skip get_snapshot() when nothing changed.
+    uint32_t get_snapshot_version() const { return this->snapshot_.get_version(); }
 
 protected:
     esphome::InternalGPIOPin *ac_tx_pin_;
     esphome::InternalGPIOPin *ac_rx_pin_;
-    esphome::InternalGPIOPin *panel_tx_pin_;
-    esphome::InternalGPIOPin *panel_rx_pin_;
+    esphome::InternalGPIOPin *panel_tx_pin_ = nullptr;
+    esphome::InternalGPIOPin *panel_rx_pin_ = nullptr;
     esphome::binary_sensor::BinarySensor *water_full_sensor;
     // esphome::ota::OTAComponent *OTAComponent =
 
     rmt_obj_t *rmt_ac_tx;
-    rmt_obj_t *rmt_panel_tx;
+    rmt_obj_t *rmt_panel_tx = nullptr;
+
+    // headless mode, in ms
+    uint32_t keepalive_interval_ = 100;
+
+    // hardware passthrough, used whenever no rewrite or button press needs the software encoder
+    bool passthrough_ = false;
+    JHSPassthroughRoute ac_to_panel_route;
+    JHSPassthroughRoute panel_to_ac_route;
+    // frame generated by us (not forwarded from the AC), held until the AC->panel route is back in software
+    std::vector<uint8_t> pending_panel_frame;
+
+    // when set, current_temperature comes from this sensor and the AC setpoint is driven by the thermostat
+    esphome::sensor::Sensor *room_sensor_ = nullptr;
+    JHSThermostat thermostat;
+    // setpoint we are driving the AC towards, equal to target_temperature unless the thermostat is active
+    float ac_setpoint = NAN;
+    // last setpoint shown on the display in cool mode
+    int ac_reported_setpoint = -1;
+
+    // cumulative runtimes, published at a low rate and kept in the preferences across reboots
+    JHSRuntimeStats runtime;
+    esphome::sensor::Sensor *runtime_sensors[JHS_RUNTIME_COUNTERS] = {};
+    esphome::sensor::Sensor *water_full_events_sensor = nullptr;
+    esphome::ESPPreferenceObject runtime_pref;
+    uint32_t last_runtime_publish = 0;
+    uint32_t last_runtime_save = 0;
+    const uint32_t RUNTIME_PUBLISH_INTERVAL = 60000;
+    // flash writes wear the sector, so the totals are saved rarely, and on shutdown
+    const uint32_t RUNTIME_SAVE_INTERVAL = 15 * 60000;
+    const uint32_t RUNTIME_PREF_HASH = 0x52554E54;
+
+    // batched export of every decoded frame to a UDP collector, at most one datagram per interval
+    bool telemetry_ = false;
+    IPAddress telemetry_host;
+    uint16_t telemetry_port;
+    uint32_t telemetry_interval;
+    WiFiUDP telemetry_udp;
+    JHSTelemetryEncoder telemetry;
+    uint16_t telemetry_sequence = 0;
+    uint32_t last_telemetry_flush = 0;
+    uint32_t telemetry_frames = 0;
+    uint32_t telemetry_encoded = 0;
+    uint32_t telemetry_dropped = 0;
+    uint32_t telemetry_bytes = 0;
+    uint32_t telemetry_time_us = 0;
+
+    // ring of state transitions, served by the web server, disabled when the size is 0
+    size_t history_size_ = 0;
+    JHSStateHistory history;
+#ifdef USE_JHS_HISTORY
+    esphome::web_server_base::WebServerBase *web_server_base_ = nullptr;
+#endif
 
     uint32_t last_adjustment = 0;
     const int ADJUSTMENT_INTERVAL = 100;
@@ -62,18 +208,74 @@ protected:
     // is_adjusting is set to true when a change was made externally (e.g. homeassistant) and we are in the process of pressing button
     bool is_adjusting();
 
+    // rewrites applied in place to every frame forwarded from the AC to the panel
+    JHSAcRewriteChain ac_rewrite;
+    uint32_t rewrite_frames = 0;
+    uint32_t rewrite_time_us_total = 0;
+    uint32_t rewrite_time_us_max = 0;
+    const uint32_t REWRITE_STATS_INTERVAL = 1000;
+
+    // the PM locks live in the receive ISR, sending needs none
+    uint64_t last_pm_rx_held_us = 0;
+
+    JHSHealthStats health;
+    // times max_frame_processing_us, the host tests replace it since their esp_timer only follows the simulated time
+    unsigned long (*processing_clock_us)() = jhs_time_us;
+    // jhs_rx_queue_overflows() at the last health report, the receive task only counts up
+    uint32_t reported_queue_overflows = 0;
+
+    // written only from process_ac_frame()
+    JHSSeqlock<JHSAcSnapshot> snapshot_;
+    // set when an adjustment ended, the requested state is kept and checked once the last press had time to show up
+    bool verify_adjustment = false;
+    // frames received since the adjustment ended
+    int settle_frames = 0;
+    // the adjustment pressed the temperature buttons, so the setpoint is checked as well
+    bool verify_temp = false;
+    const int CONVERGENCE_SETTLE_FRAMES = 5;
+
+    uint32_t last_stats_report = 0;
+    const uint32_t STATS_REPORT_INTERVAL = 60000;
+
     float rmt_panel_tx_tick;
     float rmt_ac_tx_tick;
 
 private:
     // setup helpers
     void setup_rmt();
+    void setup_passthrough();
+    void setup_thermostat();
 
-    void send_rmt_data(rmt_obj_t *rmt, std::vector<uint8_t> data);
+    void run_thermostat();
+
+    void setup_runtime();
+    void publish_runtime();
+    void save_runtime();
+
+    void setup_history();
+
+    void export_frame(JHSTelemetryFrameType type, const uint8_t *frame, size_t len);
+    void flush_telemetry();
+    void report_telemetry();
+
+    void update_routes();
+    // sends a frame of our own to the panel, queued while the line is in passthrough
+    void send_panel_frame(std::vector<uint8_t> data);
+
+    void report_pm_locks();
+
+    // returns false if the frame could not be sent, e.g. the headless press slot is taken
+    bool send_rmt_data(rmt_obj_t *rmt, std::vector<uint8_t> data);
 
     void recv_from_panel();
 
     void recv_from_ac();
+    void process_ac_frame(const jhs_ac_rx_frame &rx_frame);
+
+    void report_health();
+
+    // returns true if any of the rewrite stages modified the frame
+    bool rewrite_ac_frame(uint8_t *frame);
 
     void update_screen_if_needed();
 };
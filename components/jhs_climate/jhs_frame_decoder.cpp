@@ -0,0 +1,119 @@
+#include "jhs_frame_decoder.h"
+#include <cstring>
+
+namespace
+{
+
+struct RepairCandidates
+{
+    uint8_t frame[JHS_AC_PACKET_SIZE];
+    int valid = 0;
+    bool check_structure = false;
+
+    ///@brief Packs the first JHS_AC_FRAME_BITS bits and records the frame if its checksum is valid.
+    void consider(const uint8_t *bits)
+    {
+        uint8_t candidate[JHS_AC_PACKET_SIZE] = {};
+        for (size_t i = 0; i < JHS_AC_FRAME_BITS; i++)
+        {
+            if (bits[i])
+                candidate[i / 8] |= 1 << (7 - i % 8);
+        }
+        if (!JHSAcPacket::is_checksum_valid(candidate))
+            return;
+        // the address and the two bytes that are always zero
+        if (this->check_structure && (candidate[0] != 0x90 || candidate[3] != 0 || candidate[4] != 0))
+            return;
+        // different repairs can lead to the same frame
+        if (this->valid > 0 && memcmp(candidate, this->frame, JHS_AC_PACKET_SIZE) == 0)
+            return;
+        memcpy(this->frame, candidate, JHS_AC_PACKET_SIZE);
+        this->valid++;
+    }
+};
+
+uint8_t classify(unsigned long interval)
+{
+    return interval >= JHS_ZERO_MAX_US ? 1 : 0;
+}
+
+}
+
+JHSDecodeResult jhs_decode_ac_frame(const jhs_ac_rx_frame &rx, uint8_t *frame)
+{
+    unsigned long intervals[JHS_AC_FRAME_BITS];
+    // one spare bit for the repairs which shift the frame
+    uint8_t bits[JHS_AC_FRAME_BITS + 1];
+    for (size_t i = 0; i < JHS_AC_FRAME_BITS; i++)
+    {
+        intervals[i] = rx.intervals[i] * JHS_AC_INTERVAL_UNIT_US;
+        bits[i] = classify(intervals[i]);
+    }
+
+    RepairCandidates candidates;
+    candidates.consider(bits);
+    if (candidates.valid == 1)
+    {
+        memcpy(frame, candidates.frame, JHS_AC_PACKET_SIZE);
+        return JHS_DECODE_VALID;
+    }
+    // the checksum alone lets about one in 256 wrong repairs through, repaired frames must also look like one
+    candidates.check_structure = true;
+
+    // a single bit misclassified because its interval was near the threshold
+    for (size_t i = 0; i < JHS_AC_FRAME_BITS; i++)
+    {
+        unsigned long distance = intervals[i] > JHS_ZERO_MAX_US ? intervals[i] - JHS_ZERO_MAX_US : JHS_ZERO_MAX_US - intervals[i];
+        if (distance >= JHS_REPAIR_FLIP_MARGIN_US)
+            continue;
+        bits[i] ^= 1;
+        candidates.consider(bits);
+        bits[i] ^= 1;
+    }
+
+    uint8_t shifted[JHS_AC_FRAME_BITS + 1];
+
+    // a missing edge merged two bits into one long interval, the last interval then belongs to the lead-out
+    for (size_t i = 0; i + 1 < JHS_AC_FRAME_BITS; i++)
+    {
+        if (intervals[i] < JHS_ONE_MAX_US)
+            continue;
+        memcpy(shifted, bits, i);
+        memcpy(shifted + i + 2, bits + i + 1, JHS_AC_FRAME_BITS - i - 1);
+        // 0+1 and 1+0 are both 1500 us long, 1+1 is 2000 us
+        if (intervals[i] < 1750)
+        {
+            shifted[i] = 0;
+            shifted[i + 1] = 1;
+            candidates.consider(shifted);
+            shifted[i] = 1;
+            shifted[i + 1] = 0;
+            candidates.consider(shifted);
+        }
+        else
+        {
+            shifted[i] = 1;
+            shifted[i + 1] = 1;
+            candidates.consider(shifted);
+        }
+    }
+
+    // an extra edge split a bit in two, so the frame was cut short and its last bit is unknown
+    for (size_t i = 0; i + 1 < JHS_AC_FRAME_BITS; i++)
+    {
+        if (intervals[i] >= JHS_REPAIR_RUNT_MAX_US && intervals[i + 1] >= JHS_REPAIR_RUNT_MAX_US)
+            continue;
+        memcpy(shifted, bits, i);
+        shifted[i] = classify(intervals[i] + intervals[i + 1]);
+        memcpy(shifted + i + 1, bits + i + 2, JHS_AC_FRAME_BITS - i - 2);
+        shifted[JHS_AC_FRAME_BITS - 1] = 0;
+        candidates.consider(shifted);
+        shifted[JHS_AC_FRAME_BITS - 1] = 1;
+        candidates.consider(shifted);
+    }
+
+    if (candidates.valid != 1)
+        return JHS_DECODE_UNRECOVERABLE;
+    memcpy(frame, candidates.frame, JHS_AC_PACKET_SIZE);
+    return JHS_DECODE_REPAIRED;
+}
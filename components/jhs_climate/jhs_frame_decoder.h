@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include "jhs_recv_task.h"
+
+enum JHSDecodeResult
+{
+    JHS_DECODE_VALID,
+    JHS_DECODE_REPAIRED,
+    JHS_DECODE_UNRECOVERABLE,
+};
+
+// a zero/one interval this close to JHS_ZERO_MAX_US may have been misclassified
+const unsigned long JHS_REPAIR_FLIP_MARGIN_US = 150;
+// intervals shorter than this are not a whole bit, an extra edge split one in two
+const unsigned long JHS_REPAIR_RUNT_MAX_US = 350;
+
+///@brief Decodes the edge intervals of an AC frame into wire format.
+/// When the checksum fails, it tries a bounded set of repairs: flipping a bit whose interval was close to the
+/// zero/one threshold, splitting an interval merged by a missing edge, or merging intervals split by an extra edge.
+/// A repaired frame is only accepted if exactly one distinct candidate has a valid checksum, the 0x90 address and
+/// zeros in the two unused bytes.
+/// A missing edge between two zeros cannot be repaired: the merged interval is 1000 us long, a valid one, so nothing
+/// marks where the frame lost a bit. Such frames are dropped unless the shifted bits happen to pass the checksum,
+/// tests/test_frame_decoder.cpp measures how often that happens.
+JHSDecodeResult jhs_decode_ac_frame(const jhs_ac_rx_frame &rx, uint8_t *frame);
@@ -0,0 +1,124 @@
+#include "jhs_headless.h"
+#include "jhs_rmt_encoder.h"
+#include "jhs_pm.h"
+
+#include <cstring>
+#include "esp_ipc.h"
+#include "soc/rmt_struct.h"
+#include "soc/gpio_struct.h"
+#include "soc/gpio_sig_map.h"
+
+static const size_t FRAME_ITEMS = jhs_rmt_items_for(JHS_PANEL_PACKET_SIZE);
+// hardware timer not used by ESPHome itself
+static const uint8_t HEADLESS_TIMER = 3;
+
+static jhs_headless_config headless_config;
+static hw_timer_t *keepalive_timer = nullptr;
+static int rmt_channel = -1;
+
+static rmt_data_t keepalive_items[FRAME_ITEMS];
+static size_t keepalive_count = 0;
+static uint32_t keepalive_duration_us = 0;
+static rmt_data_t press_items[FRAME_ITEMS];
+static size_t press_count = 0;
+static uint32_t press_duration_us = 0;
+static volatile bool press_pending = false;
+
+static volatile uint32_t frames_sent = 0;
+static volatile unsigned long last_frame_time = 0;
+static volatile uint32_t last_frame_duration_us = 0;
+static volatile uint32_t max_jitter_us = 0;
+
+// the timer group counts APB cycles, a lower APB frequency between frames would stretch the keepalive interval, so it
+// stays at full speed for the whole time the panel is emulated. The frames themselves are clocked from REF_TICK
+static JHSPowerLock headless_pm_lock;
+
+static void IRAM_ATTR jhs_keepalive_timer_isr()
+{
+    unsigned long now = jhs_time_us();
+    if (frames_sent > 0)
+    {
+        unsigned long interval = now - last_frame_time;
+        // the previous frame is still being sent, refilling the channel memory now would corrupt it
+        if (interval < last_frame_duration_us)
+            return;
+        uint32_t jitter = interval > headless_config.keepalive_interval_us ? interval - headless_config.keepalive_interval_us : headless_config.keepalive_interval_us - interval;
+        if (jitter > max_jitter_us)
+            max_jitter_us = jitter;
+    }
+    last_frame_time = now;
+
+    const rmt_data_t *items = keepalive_items;
+    size_t count = keepalive_count;
+    uint32_t duration_us = keepalive_duration_us;
+    if (press_pending)
+    {
+        items = press_items;
+        count = press_count;
+        duration_us = press_duration_us;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        RMTMEM.chan[rmt_channel].data32[i].val = items[i].val;
+    }
+    // a zero item ends the transmission
+    RMTMEM.chan[rmt_channel].data32[count].val = 0;
+    RMT.conf_ch[rmt_channel].conf1.mem_rd_rst = 1;
+    RMT.conf_ch[rmt_channel].conf1.mem_rd_rst = 0;
+    RMT.conf_ch[rmt_channel].conf1.tx_start = 1;
+
+    press_pending = false;
+    last_frame_duration_us = duration_us;
+    frames_sent = frames_sent + 1;
+}
+
+static void jhs_start_keepalive_timer(void *arg)
+{
+    // 80 MHz APB / 80 = 1 us per timer tick
+    keepalive_timer = timerBegin(HEADLESS_TIMER, 80, true);
+    // edge interrupts of the timer group are unreliable on the ESP32, Arduino only supports level ones
+    timerAttachInterrupt(keepalive_timer, jhs_keepalive_timer_isr, false);
+    timerAlarmWrite(keepalive_timer, headless_config.keepalive_interval_us, true);
+    timerAlarmEnable(keepalive_timer);
+}
+
+void start_jhs_headless(jhs_headless_config config)
+{
+    headless_config = config;
+    rmt_channel = GPIO.func_out_sel_cfg[config.ac_tx_pin].func_sel - RMT_SIG_OUT0_IDX;
+    keepalive_count = jhs_rmt_encode(KEEPALIVE_PACKET.data(), JHS_PANEL_PACKET_SIZE, keepalive_items);
+    // the channel is clocked from the 1 us REF_TICK, see setup_rmt()
+    keepalive_duration_us = jhs_rmt_duration(keepalive_items, keepalive_count);
+
+    headless_pm_lock.create("jhs_headless", JHSPowerLock::APB_FREQ_MAX);
+    headless_pm_lock.acquire();
+    // like the RX interrupts, keep the timer interrupt off the core running the main loop
+    esp_ipc_call_blocking(0, jhs_start_keepalive_timer, nullptr);
+}
+
+bool jhs_headless_ready()
+{
+    return !press_pending;
+}
+
+bool jhs_headless_send(const uint8_t *frame)
+{
+    if (press_pending)
+        return false;
+    press_count = jhs_rmt_encode(frame, JHS_PANEL_PACKET_SIZE, press_items);
+    press_duration_us = jhs_rmt_duration(press_items, press_count);
+    // the timer ISR runs on the other core, the items must be visible before the flag
+    __sync_synchronize();
+    press_pending = true;
+    return true;
+}
+
+uint32_t jhs_headless_frames_sent()
+{
+    return frames_sent;
+}
+
+uint32_t jhs_headless_max_jitter_us()
+{
+    return max_jitter_us;
+}
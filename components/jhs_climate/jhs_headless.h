@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include "jhs_recv_task.h"
+
+struct jhs_headless_config
+{
+    int ac_tx_pin;
+    uint32_t keepalive_interval_us;
+};
+
+///@brief Starts a hardware timer which sends a frame to the AC every keepalive interval, emulating the control panel.
+/// Frames are written straight into the RMT channel memory from the timer ISR, so the cadence does not depend on the main loop.
+/// Must be called after the RMT channel of ac_tx_pin was initialized.
+void start_jhs_headless(jhs_headless_config config);
+
+///@brief True if a button press can be queued, i.e. the previous one has already replaced a keepalive.
+bool jhs_headless_ready();
+
+///@brief Queues a panel frame (a button press) to be sent instead of the next keepalive. Returns false if not ready.
+bool jhs_headless_send(const uint8_t *frame);
+
+uint32_t jhs_headless_frames_sent();
+///@brief Largest deviation of the time between two frames from the keepalive interval.
+uint32_t jhs_headless_max_jitter_us();
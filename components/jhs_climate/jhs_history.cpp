@@ -0,0 +1,138 @@
+#include "jhs_history.h"
+#include <algorithm>
+
+// varint (at most 5 bytes), flags and the setpoint
+static const size_t MAX_RECORD_SIZE = 5 + 1 + 1;
+
+uint8_t jhs_history_flags(const JHSAcPacket &packet, bool water_full, bool adjusting)
+{
+    uint8_t flags = JHS_HISTORY_MODE_OFF;
+    if (packet.cool)
+        flags = JHS_HISTORY_MODE_COOL;
+    else if (packet.heat)
+        flags = JHS_HISTORY_MODE_HEAT;
+    else if (packet.fan)
+        flags = JHS_HISTORY_MODE_FAN_ONLY;
+    else if (packet.dehum)
+        flags = JHS_HISTORY_MODE_DEHUM;
+    if (packet.fan_high && !packet.fan_low)
+        flags |= JHS_HISTORY_FAN_HIGH;
+    if (packet.sleep)
+        flags |= JHS_HISTORY_SLEEP;
+    if (water_full)
+        flags |= JHS_HISTORY_WATER_FULL;
+    if (adjusting)
+        flags |= JHS_HISTORY_ADJUSTING;
+    return flags;
+}
+
+void JHSStateHistory::init(size_t size)
+{
+    this->buffer_ = new uint8_t[size];
+    this->size_ = size;
+}
+
+void JHSStateHistory::evict_oldest()
+{
+    uint32_t offset = this->tail_;
+    uint32_t delta = 0;
+    uint8_t b;
+    int shift = 0;
+    do
+    {
+        b = this->at(offset++);
+        delta |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    uint8_t flags = this->at(offset++);
+    if (flags & JHS_HISTORY_SETPOINT_FOLLOWS)
+        this->anchor_setpoint_ = this->at(offset++);
+
+    this->anchor_time_s_ += delta;
+    this->anchor_flags_ = flags & ~JHS_HISTORY_SETPOINT_FOLLOWS;
+    this->has_anchor_ = true;
+    this->tail_ = offset;
+    this->records_--;
+}
+
+void JHSStateHistory::record(uint8_t flags, int setpoint, uint32_t now_s)
+{
+    if (!this->is_enabled())
+        return;
+    uint8_t new_setpoint = setpoint >= 0 ? setpoint : this->last_setpoint_;
+    if (this->has_last_ && flags == this->last_flags_ && new_setpoint == this->last_setpoint_)
+        return;
+
+    uint8_t record[MAX_RECORD_SIZE];
+    size_t len = 0;
+    // the first record is relative to the anchor, which starts out as an all zero state at boot
+    uint32_t delta = now_s - this->last_time_s_;
+    do
+    {
+        uint8_t b = delta & 0x7F;
+        delta >>= 7;
+        record[len++] = delta ? b | 0x80 : b;
+    } while (delta);
+    if (new_setpoint != this->last_setpoint_)
+    {
+        record[len++] = flags | JHS_HISTORY_SETPOINT_FOLLOWS;
+        record[len++] = new_setpoint;
+    }
+    else
+    {
+        record[len++] = flags;
+    }
+
+    std::lock_guard<std::mutex> guard(this->lock_);
+    while (this->size_ - (this->head_ - this->tail_) < len)
+    {
+        this->evict_oldest();
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        this->buffer_[this->head_++ % this->size_] = record[i];
+    }
+    this->records_++;
+
+    this->has_last_ = true;
+    this->last_time_s_ = now_s;
+    this->last_flags_ = flags;
+    this->last_setpoint_ = new_setpoint;
+}
+
+void JHSStateHistory::snapshot(uint32_t now_s, std::vector<uint8_t> &body)
+{
+    std::lock_guard<std::mutex> guard(this->lock_);
+    uint16_t length = this->head_ - this->tail_;
+    body.resize(JHS_HISTORY_HEADER_SIZE + length);
+    body[0] = 'J';
+    body[1] = 'H';
+    body[2] = JHS_HISTORY_VERSION;
+    body[3] = this->has_anchor_;
+    for (int i = 0; i < 4; i++)
+    {
+        body[4 + i] = (now_s >> (8 * i)) & 0xFF;
+        body[8 + i] = (this->anchor_time_s_ >> (8 * i)) & 0xFF;
+    }
+    body[12] = this->anchor_flags_;
+    body[13] = this->anchor_setpoint_;
+    body[14] = length & 0xFF;
+    body[15] = length >> 8;
+    for (uint16_t i = 0; i < length; i++)
+    {
+        body[JHS_HISTORY_HEADER_SIZE + i] = this->at(this->tail_ + i);
+    }
+}
+
+JHSHistoryStream::JHSHistoryStream(JHSStateHistory *history, uint32_t now_s)
+{
+    history->snapshot(now_s, this->body_);
+}
+
+size_t JHSHistoryStream::read(uint8_t *out, size_t max_len)
+{
+    size_t len = std::min(max_len, this->body_.size() - this->sent_);
+    std::copy(this->body_.begin() + this->sent_, this->body_.begin() + this->sent_ + len, out);
+    this->sent_ += len;
+    return len;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "jhs_packets.h"
+
+const uint8_t JHS_HISTORY_VERSION = 1;
+const size_t JHS_HISTORY_HEADER_SIZE = 16;
+
+// state flags, the low bits hold a JHSHistoryMode
+const uint8_t JHS_HISTORY_MODE_MASK = 0x07;
+const uint8_t JHS_HISTORY_FAN_HIGH = 1 << 3;
+const uint8_t JHS_HISTORY_SLEEP = 1 << 4;
+const uint8_t JHS_HISTORY_WATER_FULL = 1 << 5;
+const uint8_t JHS_HISTORY_ADJUSTING = 1 << 6;
+// only in records, the setpoint byte follows the flags
+const uint8_t JHS_HISTORY_SETPOINT_FOLLOWS = 1 << 7;
+
+enum JHSHistoryMode : uint8_t
+{
+    JHS_HISTORY_MODE_OFF = 0,
+    JHS_HISTORY_MODE_COOL,
+    JHS_HISTORY_MODE_DEHUM,
+    JHS_HISTORY_MODE_FAN_ONLY,
+    JHS_HISTORY_MODE_HEAT,
+};
+
+///@brief State flags describing an AC frame, in the same order of precedence as the climate mode.
+uint8_t jhs_history_flags(const JHSAcPacket &packet, bool water_full, bool adjusting);
+
+///@brief A fixed size ring of delta encoded state transitions.
+///
+/// Record: seconds since the previous record:varint | flags:u8 | setpoint:u8, only if it changed
+/// When the ring is full the oldest records are folded into the anchor, the state (and the time it was
+/// entered) the first record in the ring is relative to. record() and read() may be called from different tasks.
+class JHSStateHistory
+{
+public:
+    ///@brief Allocates the ring, size is the memory budget in bytes.
+    void init(size_t size);
+    bool is_enabled() const { return this->buffer_ != nullptr; }
+
+    ///@brief Appends a record if the state changed. A negative setpoint (something else on the display) keeps the last one.
+    void record(uint8_t flags, int setpoint, uint32_t now_s);
+
+    ///@brief Replaces body with the header followed by a copy of the records currently in the ring, at most the ring size.
+    void snapshot(uint32_t now_s, std::vector<uint8_t> &body);
+
+    size_t get_size() const { return this->size_; }
+    size_t get_used() const { return this->head_ - this->tail_; }
+    uint32_t get_records() const { return this->records_; }
+
+protected:
+    uint8_t at(uint32_t offset) const { return this->buffer_[offset % this->size_]; }
+    void evict_oldest();
+
+    std::mutex lock_;
+    uint8_t *buffer_ = nullptr;
+    size_t size_ = 0;
+    // absolute offsets, the ring holds the bytes between them
+    uint32_t head_ = 0;
+    uint32_t tail_ = 0;
+    uint32_t records_ = 0;
+
+    bool has_anchor_ = false;
+    uint32_t anchor_time_s_ = 0;
+    uint8_t anchor_flags_ = 0;
+    uint8_t anchor_setpoint_ = 0;
+
+    bool has_last_ = false;
+    uint32_t last_time_s_ = 0;
+    uint8_t last_flags_ = 0;
+    uint8_t last_setpoint_ = 0;
+};
+
+///@brief Produces the history endpoint body in chunks: the header followed by the records.
+///
+/// Header (little endian):
+///   'J' 'H' version anchor valid:u8 | uptime s:u32 | anchor uptime s:u32 | anchor flags:u8 | anchor setpoint:u8 | record bytes:u16
+/// Decoded by tools/jhs_history_dump.py. Timestamps are seconds of uptime, the client converts them to wall clock time
+/// using the uptime in the header. The body is copied when the stream is created, records added while it is sent do not
+/// change it.
+class JHSHistoryStream
+{
+public:
+    JHSHistoryStream(JHSStateHistory *history, uint32_t now_s);
+
+    size_t get_length() const { return this->body_.size(); }
+    ///@brief Fills the next chunk, 0 when done.
+    size_t read(uint8_t *out, size_t max_len);
+
+protected:
+    std::vector<uint8_t> body_;
+    size_t sent_ = 0;
+};
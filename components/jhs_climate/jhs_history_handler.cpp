@@ -0,0 +1,30 @@
+#include "jhs_history_handler.h"
+#ifdef USE_JHS_HISTORY
+
+#include <memory>
+#include "esp_timer.h"
+
+namespace esphome
+{
+namespace JHSClimate
+{
+
+bool JHSHistoryHandler::canHandle(AsyncWebServerRequest *request)
+{
+    return request->method() == HTTP_GET && request->url() == "/jhs_climate/history";
+}
+
+void JHSHistoryHandler::handleRequest(AsyncWebServerRequest *request)
+{
+    // the body is copied once under the history lock, records added while it is sent would overwrite the ring
+    auto stream = std::make_shared<JHSHistoryStream>(this->history_, esp_timer_get_time() / 1000000);
+    AsyncWebServerResponse *response = request->beginResponse("application/octet-stream", stream->get_length(),
+                                                              [stream](uint8_t *buffer, size_t max_len, size_t index) -> size_t
+                                                              { return stream->read(buffer, max_len); });
+    request->send(response);
+}
+
+}
+}
+
+#endif
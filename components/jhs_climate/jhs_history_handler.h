@@ -0,0 +1,31 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+#ifdef USE_JHS_HISTORY
+
+#include "esphome/components/web_server_base/web_server_base.h"
+#include "jhs_history.h"
+
+namespace esphome
+{
+namespace JHSClimate
+{
+
+///@brief Serves the state history at /jhs_climate/history, see JHSHistoryStream for the format.
+class JHSHistoryHandler : public AsyncWebHandler
+{
+public:
+    JHSHistoryHandler(JHSStateHistory *history) : history_(history) {}
+
+    bool canHandle(AsyncWebServerRequest *request) override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+    bool isRequestHandlerTrivial() override { return true; }
+
+protected:
+    JHSStateHistory *history_;
+};
+
+}
+}
+
+#endif
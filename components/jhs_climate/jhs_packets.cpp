@@ -1,7 +1,6 @@
 #include "jhs_packets.h"
-#include <sstream>
+#include <cstdio>
 #include <cstring>
-#include <iomanip>
 
 #include "esphome/core/log.h"
 
@@ -98,47 +97,51 @@ static uint8_t char_to_seven_segment(char c)
     }
 }
 
-std::string bytes_to_hex(std::vector<uint8_t> bytes)
+std::string bytes_to_hex(const uint8_t *data, size_t len)
 {
-    std::stringstream ss;
-    for (auto b : bytes)
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(len * 2);
+    for (size_t i = 0; i < len; i++)
     {
-        ss << std::hex << std::setfill('0') << std::setw(2) << (int)b;
+        hex += HEX_DIGITS[data[i] >> 4];
+        hex += HEX_DIGITS[data[i] & 0x0F];
     }
-    return ss.str();
+    return hex;
 }
 
 std::string JHSAcPacket::to_string()
 {
-    std::stringstream ss;
-    ss << "DISP:";
-    ss << seven_segment_to_char(first_digit);
-    ss << seven_segment_to_char(second_digit);
+    std::string str = "DISP:";
+    str += seven_segment_to_char(first_digit);
+    str += seven_segment_to_char(second_digit);
     if (this->power)
-        ss << " POWER";
+        str += " POWER";
     if (this->cool)
-        ss << " COOL";
+        str += " COOL";
     if (this->dehum)
-        ss << " DEHUM";
+        str += " DEHUM";
     if (this->heat)
-        ss << " HEAT";
+        str += " HEAT";
     if (this->fan)
-        ss << " FANONLY";
+        str += " FANONLY";
     if (this->fan_low)
-        ss << " FANLOW";
+        str += " FANLOW";
     if (this->fan_high)
-        ss << " FANHIGH";
+        str += " FANHIGH";
     if (this->water_full)
-        ss << " WATERFULL";
+        str += " WATERFULL";
     if (this->sleep)
-        ss << " SLEEP";
+        str += " SLEEP";
     if (this->timer)
-        ss << " TIMER";
+        str += " TIMER";
     if (this->beep_amount > 0 && this->beep_length > 0)
     {
-        ss << " BEEP " << (int)this->beep_amount << " times, " << (int)this->beep_length;
+        char beep[32];
+        snprintf(beep, sizeof(beep), " BEEP %d times, %d", (int)this->beep_amount, (int)this->beep_length);
+        str += beep;
     }
-    return ss.str();
+    return str;
 }
 
 int JHSAcPacket::get_temp()
@@ -166,6 +169,16 @@ void JHSAcPacket::set_display(std::string temp)
     second_digit = char_to_seven_segment(temp[1]);
 }
 
+bool JHSAcPacket::is_checksum_valid(const uint8_t *data)
+{
+    uint8_t checksum = 90;
+    for (size_t i = 0; i < sizeof(JHSAcPacket); i++)
+    {
+        checksum += data[i];
+    }
+    return checksum == data[sizeof(JHSAcPacket)];
+}
+
 esphome::optional<JHSAcPacket> JHSAcPacket::parse(const std::vector<uint8_t> &data)
 {
 
@@ -184,7 +197,7 @@ esphome::optional<JHSAcPacket> JHSAcPacket::parse(const std::vector<uint8_t> &da
     }
     if (checksum != checksum_calculated)
     {
-        ESP_LOGV(TAG, "JHS AC packet checksum mismatch: %d != %d in packet: %s", checksum, checksum_calculated, bytes_to_hex(data).c_str());
+        ESP_LOGV(TAG, "JHS AC packet checksum mismatch: %d != %d in packet: %s", checksum, checksum_calculated, bytes_to_hex(data.data(), data.size()).c_str());
         return esphome::optional<JHSAcPacket>();
     }
     return esphome::make_optional(packet);
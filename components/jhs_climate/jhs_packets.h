@@ -22,6 +22,8 @@ const std::array<uint8_t, 3> BUTTON_SLEEP{0x30, 0x07, 0x91};
 const std::array<uint8_t, 3> BUTTON_HIGHER_TEMP{0x30, 0x08, 0x92};
 const std::array<uint8_t, 3> BUTTON_UNIT_CHANGE{0x30, 0x09, 0x93};
 
+///@brief Formats bytes as lowercase hex without pulling in iostreams.
+std::string bytes_to_hex(const uint8_t *data, size_t len);
 
 ///@brief Packet sent from the AC to the panel.
 struct JHSAcPacket
@@ -63,6 +65,9 @@ struct JHSAcPacket
     int get_temp();
     void set_display(std::string);
 
+    ///@brief Checks the checksum of a frame in wire format (sizeof(JHSAcPacket) + 1 bytes).
+    static bool is_checksum_valid(const uint8_t *data);
+
     ///@brief Parses the packet and checks the checksum.
     static esphome::optional<JHSAcPacket> parse(const std::vector<uint8_t> &data);
 
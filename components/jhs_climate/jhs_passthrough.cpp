@@ -0,0 +1,41 @@
+#include "jhs_passthrough.h"
+#include "jhs_recv_task.h"
+#include "jhs_pm.h"
+
+#include "esp32/rom/gpio.h"
+#include "soc/gpio_struct.h"
+
+void JHSPassthroughRoute::setup(int rx_pin, int tx_pin, uint32_t signal)
+{
+    this->tx_pin_ = tx_pin;
+    this->signal_ = signal;
+    // remember the RMT output signal attached by rmtInit() so it can be restored later
+    this->software_signal_ = GPIO.func_out_sel_cfg[tx_pin].func_sel;
+    gpio_matrix_in(rx_pin, signal, false);
+    this->enabled_ = true;
+}
+
+bool JHSPassthroughRoute::is_passthrough() const
+{
+    // read back from the hardware, the receive ISR may have switched to passthrough on its own
+    return this->enabled_ && GPIO.func_out_sel_cfg[this->tx_pin_].func_sel == this->signal_;
+}
+
+void JHSPassthroughRoute::mark_tx(uint32_t duration_us)
+{
+    this->tx_busy_until_ = jhs_time_us() + duration_us;
+}
+
+bool JHSPassthroughRoute::update(unsigned long rx_idle_us)
+{
+    if (!this->enabled_ || this->want_passthrough_ == this->is_passthrough())
+        return false;
+    // a frame is being received
+    if (rx_idle_us < JHS_MAX_EDGE_INTERVAL_US)
+        return false;
+    // the RMT is still sending a frame
+    if ((int32_t)(jhs_time_us() - this->tx_busy_until_) < 0)
+        return false;
+    gpio_matrix_out(this->tx_pin_, this->want_passthrough_ ? this->signal_ : this->software_signal_, false, false);
+    return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include "soc/gpio_sig_map.h"
+
+// GPIO matrix signals that can be routed from an input pin straight to an output pin
+const uint32_t JHS_AC_TO_PANEL_SIGNAL = SIG_IN_FUNC224_IDX;
+const uint32_t JHS_PANEL_TO_AC_SIGNAL = SIG_IN_FUNC225_IDX;
+
+///@brief Switches a TX pin between the RMT encoder and a direct GPIO matrix connection to an RX pin.
+/// The RX pin stays connected to its interrupt, so frames are decoded in both modes.
+class JHSPassthroughRoute
+{
+public:
+    ///@brief Must be called after rmtInit() attached the TX pin to its RMT channel.
+    void setup(int rx_pin, int tx_pin, uint32_t signal);
+
+    bool is_enabled() const { return this->enabled_; }
+    bool is_passthrough() const;
+
+    ///@brief Requests passthrough (or software re-encoding), applied by update() on the next frame boundary.
+    void request(bool passthrough) { this->want_passthrough_ = passthrough; }
+
+    ///@brief Tells the route that a software transmission of the given duration has started.
+    void mark_tx(uint32_t duration_us);
+
+    ///@brief Applies the requested mode if the RX line is idle and no software transmission is pending.
+    /// Returns true if the mode was switched.
+    bool update(unsigned long rx_idle_us);
+
+protected:
+    bool enabled_ = false;
+    int tx_pin_ = -1;
+    uint32_t signal_ = 0;
+    uint32_t software_signal_ = 0;
+    bool want_passthrough_ = false;
+    uint32_t tx_busy_until_ = 0;
+};
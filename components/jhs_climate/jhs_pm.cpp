@@ -0,0 +1,58 @@
+#include "jhs_pm.h"
+
+#include "esphome/core/log.h"
+
+#ifdef CONFIG_PM_ENABLE
+static const char *TAG = "JHSClimate";
+#endif
+
+void JHSPowerLock::create(const char *name, Type type)
+{
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_type_t pm_type = type == APB_FREQ_MAX ? ESP_PM_APB_FREQ_MAX : ESP_PM_NO_LIGHT_SLEEP;
+    esp_err_t err = esp_pm_lock_create(pm_type, 0, name, &this->handle_);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to create PM lock %s: %d", name, err);
+        this->handle_ = nullptr;
+    }
+#endif
+}
+
+void IRAM_ATTR JHSPowerLock::acquire()
+{
+    if (this->held_)
+        return;
+#ifdef CONFIG_PM_ENABLE
+    if (this->handle_ != nullptr)
+        esp_pm_lock_acquire(this->handle_);
+#endif
+    portENTER_CRITICAL_SAFE(&this->lock_);
+    this->acquired_at_ = jhs_time_us();
+    this->held_ = true;
+    portEXIT_CRITICAL_SAFE(&this->lock_);
+}
+
+void IRAM_ATTR JHSPowerLock::release()
+{
+    if (!this->held_)
+        return;
+#ifdef CONFIG_PM_ENABLE
+    if (this->handle_ != nullptr)
+        esp_pm_lock_release(this->handle_);
+#endif
+    portENTER_CRITICAL_SAFE(&this->lock_);
+    this->held_total_us_ += jhs_time_us() - this->acquired_at_;
+    this->held_ = false;
+    portEXIT_CRITICAL_SAFE(&this->lock_);
+}
+
+uint64_t JHSPowerLock::get_held_time_us() const
+{
+    portENTER_CRITICAL_SAFE(&this->lock_);
+    uint64_t total = this->held_total_us_;
+    if (this->held_)
+        total += jhs_time_us() - this->acquired_at_;
+    portEXIT_CRITICAL_SAFE(&this->lock_);
+    return total;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#ifdef CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#endif
+
+///@brief Monotonic microsecond clock that keeps counting correctly while the power manager scales the CPU and APB clocks.
+inline unsigned long IRAM_ATTR jhs_time_us()
+{
+    return (unsigned long)esp_timer_get_time();
+}
+
+///@brief Wrapper around an ESP-IDF power management lock which also accounts the time it was held.
+/// Compiles to bookkeeping only when power management is disabled in the sdkconfig.
+class JHSPowerLock
+{
+public:
+    enum Type
+    {
+        // keeps the APB clock (and thus GPIO interrupt latency) at its maximum and prevents light sleep
+        APB_FREQ_MAX,
+        // only prevents light sleep, enough for peripherals clocked from REF_TICK
+        NO_LIGHT_SLEEP,
+    };
+
+    void create(const char *name, Type type);
+
+    ///@brief Can be called from an ISR, does nothing if the lock is already held.
+    void acquire();
+    ///@brief Can be called from an ISR, does nothing if the lock is not held.
+    void release();
+
+    bool is_held() const { return this->held_; }
+    ///@brief Total time the lock was held since boot, including the current hold.
+    uint64_t get_held_time_us() const;
+
+protected:
+#ifdef CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t handle_ = nullptr;
+#endif
+    // the ISRs and the main loop run on different cores, the 64 bit total cannot be read or written atomically
+    mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+    volatile bool held_ = false;
+    volatile unsigned long acquired_at_ = 0;
+    volatile uint64_t held_total_us_ = 0;
+};
@@ -1,69 +1,113 @@
 #include "jhs_recv_task.h"
 #include <cstring>
 #include <freertos/FreeRTOS.h>
+#include "jhs_passthrough.h"
+#include "jhs_pm.h"
+#include "esp32/rom/gpio.h"
+#include "esp_ipc.h"
+#include "driver/gpio.h"
 
 
+static const char *TAG = "JHSClimate";
+
 volatile QueueHandle_t ac_rx_queue;
 volatile QueueHandle_t panel_rx_queue;
 
-static TaskHandle_t interrupt_task;
+static jhs_recv_task_config recv_config;
+
+// held from the first edge of a frame until it is complete, so the clocks are not scaled down in the middle of it
+static JHSPowerLock ac_rx_pm_lock;
+static JHSPowerLock panel_rx_pm_lock;
+// the ESP32 can only wake from light sleep on a GPIO level, which would replace the falling edge interrupt type
+// of the RX pins, so light sleep is blocked for as long as the lines are listened to
+static JHSPowerLock rx_sleep_lock;
+
+static volatile uint32_t rx_queue_overflows = 0;
+// set on a queue overflow, each line is switched to passthrough by its own ISR at the start of its next frame
+static volatile bool ac_fallback_pending = false;
+static volatile bool panel_fallback_pending = false;
+
+static void IRAM_ATTR jhs_rx_queue_overflow()
+{
+    rx_queue_overflows++;
+    if (!recv_config.passthrough_fallback)
+        return;
+    // the main loop is stalled, keep the AC and the panel talking through the GPIO matrix, but switching now
+    // would cut a frame which is on the other line at the moment
+    ac_fallback_pending = true;
+    panel_fallback_pending = true;
+}
+
+///@brief Called on the first falling edge after a gap: connects the TX pin to the RX line if a fallback is pending.
+/// The line was idle (high) until this edge, so the output only starts the lead-in a few microseconds late. The RMT
+/// is idle as well, the main loop did not send anything for as long as it took to fill the queue.
+static void IRAM_ATTR jhs_rx_fallback(volatile bool &pending, int tx_pin, uint32_t signal)
+{
+    if (!pending)
+        return;
+    pending = false;
+    gpio_matrix_out(tx_pin, signal, false, false);
+}
 
 static volatile unsigned long ac_rx_last_falling_edge_time = 0;
 static volatile unsigned int ac_rx_bits_from_start = 0;
-static volatile uint8_t ac_rx_packet[JHS_AC_PACKET_SIZE];
+static volatile jhs_ac_rx_frame ac_rx_frame;
 
-static void IRAM_ATTR jhs_ac_rx_isr()
+static void IRAM_ATTR jhs_ac_rx_isr(void *arg)
 {
-    unsigned long length = micros() - ac_rx_last_falling_edge_time;
-    ac_rx_last_falling_edge_time = micros();
-    if (length > 20 && length < 32 * 250)
+    unsigned long now = jhs_time_us();
+    unsigned long length = now - ac_rx_last_falling_edge_time;
+    ac_rx_last_falling_edge_time = now;
+    if (length > 20 && length < JHS_MAX_EDGE_INTERVAL_US)
     {
-        if (length < 2 * 250 + 280)
-        {
-            // zero
-            ac_rx_bits_from_start++;
-        }
-        else if (length < 4 * 250 + 250)
+        if (length < JHS_START_MIN_US)
         {
-            // set bit in packet to one
-            ac_rx_packet[ac_rx_bits_from_start / 8] |= (1 << (7 - ac_rx_bits_from_start % 8));
+            // keep the raw interval, bits are classified (and repaired if needed) in the main loop
+            ac_rx_frame.intervals[ac_rx_bits_from_start] = (length + JHS_AC_INTERVAL_UNIT_US / 2) / JHS_AC_INTERVAL_UNIT_US;
             ac_rx_bits_from_start++;
         }
         else
         {
             // start
+            ac_rx_pm_lock.acquire();
             ac_rx_bits_from_start = 0;
-            // clear packet
-            for (int i = 0; i < JHS_AC_PACKET_SIZE; i++)
-            {
-                ac_rx_packet[i] = 0;
-            }
         }
-        if (ac_rx_bits_from_start == JHS_AC_PACKET_SIZE * 8)
+        if (ac_rx_bits_from_start == JHS_AC_FRAME_BITS)
         {
             ac_rx_bits_from_start = 0;
+            ac_rx_pm_lock.release();
 
-            xQueueSend(ac_rx_queue, (void *) ac_rx_packet, 0);
+            if (xQueueSend(ac_rx_queue, (void *) &ac_rx_frame, 0) != pdTRUE)
+            {
+                jhs_rx_queue_overflow();
+            }
         }
     }
+    else if (length >= JHS_MAX_EDGE_INTERVAL_US)
+    {
+        // first edge after a gap, the lead-in of the next frame, raise the clocks before the start bit is timed
+        ac_rx_pm_lock.acquire();
+        jhs_rx_fallback(ac_fallback_pending, recv_config.panel_tx_pin, JHS_AC_TO_PANEL_SIGNAL);
+    }
 }
 
 static volatile unsigned long panel_rx_last_falling_edge_time = 0;
 static volatile unsigned int panel_rx_bits_from_start = 0;
 static volatile uint8_t panel_rx_packet[JHS_PANEL_PACKET_SIZE];
 
-static void IRAM_ATTR jhs_panel_rx_isr()
+static void IRAM_ATTR jhs_panel_rx_isr(void *arg)
 {
-    unsigned long length = micros() - panel_rx_last_falling_edge_time;
-    panel_rx_last_falling_edge_time = micros();
-    if (length > 20 && length < 32 * 250)
+    unsigned long now = jhs_time_us();
+    unsigned long length = now - panel_rx_last_falling_edge_time;
+    panel_rx_last_falling_edge_time = now;
+    if (length > 20 && length < JHS_MAX_EDGE_INTERVAL_US)
     {
-        if (length < 2 * 250 + 280)
+        if (length < JHS_ZERO_MAX_US)
         {
             // zero
             panel_rx_bits_from_start++;
         }
-        else if (length < 4 * 250 + 250)
+        else if (length < JHS_ONE_MAX_US)
         {
             // set bit in packet to one
             panel_rx_packet[panel_rx_bits_from_start / 8] |= (1 << (7 - panel_rx_bits_from_start % 8));
@@ -72,6 +116,7 @@ static void IRAM_ATTR jhs_panel_rx_isr()
         else
         {
             // start
+            panel_rx_pm_lock.acquire();
             panel_rx_bits_from_start = 0;
             // clear packet
             for (int i = 0; i < JHS_PANEL_PACKET_SIZE; i++)
@@ -82,29 +127,90 @@ static void IRAM_ATTR jhs_panel_rx_isr()
         if (panel_rx_bits_from_start == JHS_PANEL_PACKET_SIZE * 8)
         {
             panel_rx_bits_from_start = 0;
+            panel_rx_pm_lock.release();
 
-            xQueueSend(panel_rx_queue, (void *) panel_rx_packet, 0);
+            if (xQueueSend(panel_rx_queue, (void *) panel_rx_packet, 0) != pdTRUE)
+            {
+                jhs_rx_queue_overflow();
+            }
         }
     }
+    else if (length >= JHS_MAX_EDGE_INTERVAL_US)
+    {
+        // first edge after a gap, the lead-in of the next frame, raise the clocks before the start bit is timed
+        panel_rx_pm_lock.acquire();
+        jhs_rx_fallback(panel_fallback_pending, recv_config.ac_tx_pin, JHS_PANEL_TO_AC_SIGNAL);
+    }
+}
+
+// runs on the 1 KB stack of the IPC task, so it does not log itself, errors are returned to the caller
+static void jhs_attach_interrupts(void *arg)
+{
+    // the service allocates the GPIO interrupt on the core it is installed from, which is what moves the handlers
+    // to core 0, with the flags Arduino uses so attachInterrupt() elsewhere shares it
+    esp_err_t *err = (esp_err_t *)arg;
+    *err = gpio_install_isr_service(0);
+    if (*err != ESP_OK && *err != ESP_ERR_INVALID_STATE)
+        return;
+    gpio_set_intr_type((gpio_num_t)recv_config.ac_rx_pin, GPIO_INTR_NEGEDGE);
+    gpio_isr_handler_add((gpio_num_t)recv_config.ac_rx_pin, jhs_ac_rx_isr, nullptr);
+    // no panel in headless mode
+    if (recv_config.panel_rx_pin >= 0)
+    {
+        gpio_set_intr_type((gpio_num_t)recv_config.panel_rx_pin, GPIO_INTR_NEGEDGE);
+        gpio_isr_handler_add((gpio_num_t)recv_config.panel_rx_pin, jhs_panel_rx_isr, nullptr);
+    }
+}
+
+unsigned long jhs_ac_rx_idle_time()
+{
+    return jhs_time_us() - ac_rx_last_falling_edge_time;
 }
 
-static void jhs_recv_task_func(void *arg)
+unsigned long jhs_panel_rx_idle_time()
 {
-    jhs_recv_task_config *config_ptr = (jhs_recv_task_config *)arg;
+    return jhs_time_us() - panel_rx_last_falling_edge_time;
+}
 
-    pinMode(config_ptr->ac_rx_pin, INPUT);
-    pinMode(config_ptr->panel_rx_pin, INPUT_PULLDOWN);
-    attachInterrupt(config_ptr->ac_rx_pin, jhs_ac_rx_isr, FALLING);
-    attachInterrupt(config_ptr->panel_rx_pin, jhs_panel_rx_isr, FALLING);
+uint32_t jhs_rx_queue_overflows()
+{
+    return rx_queue_overflows;
+}
 
-    free(config_ptr);
-    vTaskDelete(NULL);
+void jhs_rx_cancel_fallback()
+{
+    ac_fallback_pending = false;
+    panel_fallback_pending = false;
+}
+
+uint64_t jhs_rx_pm_lock_held_time_us()
+{
+    return ac_rx_pm_lock.get_held_time_us() + panel_rx_pm_lock.get_held_time_us();
 }
 
 void start_jhs_climate_recv_task(jhs_recv_task_config config)
 {
-    jhs_recv_task_config *config_ptr = new jhs_recv_task_config(config);
-    ac_rx_queue = xQueueCreate(32, JHS_AC_PACKET_SIZE);
+    recv_config = config;
+    ac_rx_pm_lock.create("jhs_ac_rx", JHSPowerLock::APB_FREQ_MAX);
+    panel_rx_pm_lock.create("jhs_panel_rx", JHSPowerLock::APB_FREQ_MAX);
+    rx_sleep_lock.create("jhs_rx", JHSPowerLock::NO_LIGHT_SLEEP);
+    rx_sleep_lock.acquire();
+    // a frame takes over 60 ms on the wire, so 16 of them are a second of a stalled main loop
+    ac_rx_queue = xQueueCreate(16, sizeof(jhs_ac_rx_frame));
     panel_rx_queue = xQueueCreate(32, JHS_PANEL_PACKET_SIZE);
-    xTaskCreatePinnedToCore(jhs_recv_task_func, "jhs_recv_task", 2048, config_ptr, 5, &interrupt_task, 0);
+    pinMode(recv_config.ac_rx_pin, INPUT);
+    if (recv_config.panel_rx_pin >= 0)
+        pinMode(recv_config.panel_rx_pin, INPUT_PULLDOWN);
+    // install the interrupt and bind the handlers from core 0, away from the main loop, using the already existing
+    // IPC task instead of spawning a task of our own
+    esp_err_t err = ESP_OK;
+    esp_ipc_call_blocking(0, jhs_attach_interrupts, &err);
+    if (err == ESP_ERR_INVALID_STATE)
+    {
+        ESP_LOGW(TAG, "The GPIO ISR service was already installed, the RX interrupts run on the core it was installed from");
+    }
+    else if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed to install the GPIO ISR service: %d", err);
+    }
 }
@@ -13,6 +13,26 @@ using namespace esphome;
 
 const size_t JHS_AC_PACKET_SIZE = (sizeof(JHSAcPacket) + 1);
 const size_t JHS_PANEL_PACKET_SIZE = 3;
+const size_t JHS_AC_FRAME_BITS = JHS_AC_PACKET_SIZE * 8;
+
+// intervals between two falling edges, a zero is nominally 500 us long and a one 1000 us
+const unsigned long JHS_ZERO_MAX_US = 2 * 250 + 280;
+const unsigned long JHS_ONE_MAX_US = 4 * 250 + 250;
+// the start bit is 6750 us long, AC intervals between JHS_ONE_MAX_US and this are two bits merged by a missing edge
+const unsigned long JHS_START_MIN_US = 3000;
+// longest interval between two falling edges within a frame (the start bit), anything longer is a gap between frames
+const unsigned long JHS_MAX_EDGE_INTERVAL_US = 32 * 250;
+
+// the ISR stores AC intervals in these units, so one fits a byte (anything shorter than JHS_START_MIN_US does)
+const unsigned long JHS_AC_INTERVAL_UNIT_US = 16;
+static_assert((JHS_START_MIN_US + JHS_AC_INTERVAL_UNIT_US / 2) / JHS_AC_INTERVAL_UNIT_US <= 0xFF, "AC interval does not fit a byte");
+
+///@brief Raw AC frame as captured by the ISR, decoded by jhs_decode_ac_frame() in the main loop.
+struct jhs_ac_rx_frame
+{
+    // rounded to JHS_AC_INTERVAL_UNIT_US, 72 bytes per queued frame instead of 144
+    uint8_t intervals[JHS_AC_FRAME_BITS];
+};
 
 extern volatile QueueHandle_t ac_rx_queue;
 extern volatile QueueHandle_t panel_rx_queue;
@@ -21,6 +41,25 @@ struct jhs_recv_task_config
 {
     int ac_rx_pin;
     int panel_rx_pin;
+    int ac_tx_pin;
+    int panel_tx_pin;
+    // route both lines through the GPIO matrix when a queue overflows because the main loop is not draining it,
+    // each one at the start of its next frame
+    bool passthrough_fallback;
 };
 
+///@brief Creates the receive queues and attaches the RX interrupts on core 0.
 void start_jhs_climate_recv_task(jhs_recv_task_config config);
+
+// time since the last falling edge on the respective RX line
+unsigned long jhs_ac_rx_idle_time();
+unsigned long jhs_panel_rx_idle_time();
+
+// frames dropped because a receive queue was full, summed over both lines
+uint32_t jhs_rx_queue_overflows();
+
+// cancels a passthrough fallback which is still waiting for the next frame boundary, called by the main loop
+void jhs_rx_cancel_fallback();
+
+// total time the RX power management locks were held, summed over both lines
+uint64_t jhs_rx_pm_lock_held_time_us();
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+#include "jhs_packets.h"
+#include "jhs_recv_task.h"
+
+namespace esphome
+{
+namespace JHSClimate
+{
+
+// Byte offsets and masks in the AC->panel wire frame (see JHSAcPacket for the bit layout)
+const size_t JHS_AC_FIRST_DIGIT_BYTE = 1;
+const size_t JHS_AC_SECOND_DIGIT_BYTE = 2;
+const size_t JHS_AC_STATUS_BYTE = 6;
+const uint8_t JHS_AC_WIFI_MASK = 1 << 3;
+const size_t JHS_AC_BEEP_BYTE = 7;
+const size_t JHS_AC_CHECKSUM_BYTE = JHS_AC_PACKET_SIZE - 1;
+
+///@brief State shared by all rewrite stages while processing a single frame.
+struct JHSRewriteContext
+{
+    bool wifi_connected;
+    bool adjusting;
+};
+
+///@brief Replaces a byte of an AC frame, patching the additive checksum instead of recomputing it.
+inline void jhs_frame_set_byte(uint8_t *frame, size_t index, uint8_t value)
+{
+    frame[JHS_AC_CHECKSUM_BYTE] += value - frame[index];
+    frame[index] = value;
+}
+
+///@brief Lights the wifi icon on the panel while the ESP is disconnected.
+struct JHSWifiIconRewrite
+{
+    bool enabled = true;
+
+    void apply(uint8_t *frame, const JHSRewriteContext &ctx) const
+    {
+        if (!this->enabled)
+            return;
+        uint8_t status = frame[JHS_AC_STATUS_BYTE] & ~JHS_AC_WIFI_MASK;
+        if (!ctx.wifi_connected)
+            status |= JHS_AC_WIFI_MASK;
+        jhs_frame_set_byte(frame, JHS_AC_STATUS_BYTE, status);
+    }
+};
+
+enum JHSBeepPolicy : uint8_t
+{
+    JHS_BEEP_POLICY_NORMAL = 0,
+    JHS_BEEP_POLICY_MUTE_WHILE_ADJUSTING,
+    JHS_BEEP_POLICY_MUTE,
+};
+
+inline const char *jhs_beep_policy_to_string(JHSBeepPolicy policy)
+{
+    switch (policy)
+    {
+    case JHS_BEEP_POLICY_NORMAL:
+        return "normal";
+    case JHS_BEEP_POLICY_MUTE_WHILE_ADJUSTING:
+        return "mute_while_adjusting";
+    case JHS_BEEP_POLICY_MUTE:
+        return "mute";
+    default:
+        return "unknown";
+    }
+}
+
+///@brief Silences the panel buzzer according to the configured policy.
+struct JHSBeepRewrite
+{
+    JHSBeepPolicy policy = JHS_BEEP_POLICY_MUTE_WHILE_ADJUSTING;
+
+    void apply(uint8_t *frame, const JHSRewriteContext &ctx) const
+    {
+        if (this->policy == JHS_BEEP_POLICY_MUTE || (this->policy == JHS_BEEP_POLICY_MUTE_WHILE_ADJUSTING && ctx.adjusting))
+            jhs_frame_set_byte(frame, JHS_AC_BEEP_BYTE, 0);
+    }
+};
+
+///@brief Replaces the two display digits with a fixed text.
+struct JHSDisplayRewrite
+{
+    bool enabled = false;
+    uint8_t first_digit = 0;
+    uint8_t second_digit = 0;
+
+    void set_text(const std::string &text)
+    {
+        JHSAcPacket digits;
+        digits.set_display(text);
+        this->first_digit = digits.first_digit;
+        this->second_digit = digits.second_digit;
+        this->enabled = !text.empty();
+    }
+
+    void apply(uint8_t *frame, const JHSRewriteContext &ctx) const
+    {
+        if (!this->enabled)
+            return;
+        jhs_frame_set_byte(frame, JHS_AC_FIRST_DIGIT_BYTE, this->first_digit);
+        jhs_frame_set_byte(frame, JHS_AC_SECOND_DIGIT_BYTE, this->second_digit);
+    }
+};
+
+///@brief A chain of rewrite stages, composed at compile time and applied in order to a frame in place.
+template <typename... Stages>
+class JHSRewriteChain
+{
+public:
+    template <typename Stage>
+    Stage &stage() { return std::get<Stage>(this->stages_); }
+
+    void apply(uint8_t *frame, const JHSRewriteContext &ctx) const
+    {
+        std::apply([&](const auto &...stages)
+                   { (stages.apply(frame, ctx), ...); },
+                   this->stages_);
+    }
+
+protected:
+    std::tuple<Stages...> stages_;
+};
+
+using JHSAcRewriteChain = JHSRewriteChain<JHSWifiIconRewrite, JHSBeepRewrite, JHSDisplayRewrite>;
+
+}
+}
@@ -0,0 +1,35 @@
+#include "jhs_rmt_encoder.h"
+
+static rmt_data_t make_item(uint32_t low, uint32_t high)
+{
+    rmt_data_t item;
+    item.level0 = 0;
+    item.duration0 = low;
+    item.level1 = 1;
+    item.duration1 = high;
+    return item;
+}
+
+size_t jhs_rmt_encode(const uint8_t *data, size_t len, rmt_data_t *items)
+{
+    size_t count = 0;
+    items[count++] = make_item(4500, 2250); // lead-in
+    for (size_t i = 0; i < len * 8; i++)
+    {
+        uint8_t bit = (data[i / 8] >> (7 - (i % 8))) & 1;
+        items[count++] = bit ? make_item(250, 750) : make_item(250, 250);
+    }
+    items[count++] = make_item(250, 250); // lead-out
+    items[count++] = make_item(500, 500); // end
+    return count;
+}
+
+uint32_t jhs_rmt_duration(const rmt_data_t *items, size_t count)
+{
+    uint32_t ticks = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        ticks += items[i].duration0 + items[i].duration1;
+    }
+    return ticks;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "esp32-hal-rmt.h"
+
+// lead-in, 8 items per byte, lead-out and the end marker
+inline constexpr size_t jhs_rmt_items_for(size_t len) { return len * 8 + 3; }
+
+///@brief Encodes a frame into RMT items, with durations in 1 us REF_TICK ticks. Returns the number of items.
+size_t jhs_rmt_encode(const uint8_t *data, size_t len, rmt_data_t *items);
+
+///@brief Total duration of the items in ticks.
+uint32_t jhs_rmt_duration(const rmt_data_t *items, size_t count);
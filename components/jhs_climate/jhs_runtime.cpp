@@ -0,0 +1,45 @@
+#include "jhs_runtime.h"
+
+void JHSRuntimeStats::update(const JHSAcPacket &packet, bool water_full, uint32_t now_ms)
+{
+    if (this->has_last_)
+    {
+        uint32_t elapsed = now_ms - this->last_ms_;
+        if (elapsed <= JHS_RUNTIME_MAX_GAP_MS)
+        {
+            for (uint8_t i = 0; i < JHS_RUNTIME_COUNTERS; i++)
+            {
+                if (this->last_active_ & (1 << i))
+                    this->totals_.runtime_ms[i] += elapsed;
+            }
+        }
+    }
+
+    uint8_t active = 0;
+    if (packet.cool)
+        active |= 1 << JHS_RUNTIME_COOL;
+    if (packet.dehum)
+        active |= 1 << JHS_RUNTIME_DEHUM;
+    if (packet.fan)
+        active |= 1 << JHS_RUNTIME_FAN_ONLY;
+    // the fan speed icons are meaningless while the AC is off
+    if (packet.cool || packet.dehum || packet.fan)
+    {
+        if (packet.fan_low)
+            active |= 1 << JHS_RUNTIME_FAN_LOW;
+        if (packet.fan_high)
+            active |= 1 << JHS_RUNTIME_FAN_HIGH;
+    }
+    if (packet.sleep)
+        active |= 1 << JHS_RUNTIME_SLEEP;
+    if (water_full)
+        active |= 1 << JHS_RUNTIME_WATER_FULL;
+
+    if (this->has_last_ && water_full && !this->last_water_full_)
+        this->totals_.water_full_events++;
+
+    this->last_active_ = active;
+    this->last_water_full_ = water_full;
+    this->last_ms_ = now_ms;
+    this->has_last_ = true;
+}
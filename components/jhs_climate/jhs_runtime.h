@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include "jhs_packets.h"
+
+enum JHSRuntimeCounter : uint8_t
+{
+    JHS_RUNTIME_COOL = 0,
+    JHS_RUNTIME_DEHUM,
+    JHS_RUNTIME_FAN_ONLY,
+    JHS_RUNTIME_FAN_LOW,
+    JHS_RUNTIME_FAN_HIGH,
+    JHS_RUNTIME_SLEEP,
+    JHS_RUNTIME_WATER_FULL,
+    JHS_RUNTIME_COUNTERS,
+};
+
+// frames further apart than this mean the AC or the ESP was not running, the gap is not counted
+const uint32_t JHS_RUNTIME_MAX_GAP_MS = 5000;
+
+///@brief Cumulative totals, stored in the preferences as they are.
+struct JHSRuntimeTotals
+{
+    uint64_t runtime_ms[JHS_RUNTIME_COUNTERS];
+    uint32_t water_full_events;
+};
+
+///@brief Integrates the state reported in AC frames into per mode and per fan speed runtimes.
+class JHSRuntimeStats
+{
+public:
+    ///@brief Counts the time since the previous frame towards the state of the previous frame.
+    void update(const JHSAcPacket &packet, bool water_full, uint32_t now_ms);
+
+    JHSRuntimeTotals &get_totals() { return this->totals_; }
+    float get_hours(JHSRuntimeCounter counter) const { return this->totals_.runtime_ms[counter] / 3600000.0f; }
+    uint32_t get_water_full_events() const { return this->totals_.water_full_events; }
+
+protected:
+    JHSRuntimeTotals totals_{};
+    bool has_last_ = false;
+    uint32_t last_ms_ = 0;
+    // bit per JHSRuntimeCounter which was active in the previous frame
+    uint8_t last_active_ = 0;
+    bool last_water_full_ = false;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+///@brief Double buffered seqlock for a single writer and any number of readers on either core.
+///
+/// The writer fills the inactive buffer and then publishes it with a single store, it never waits.
+/// Readers copy the active buffer and retry only if the writer started on that same buffer in the
+/// meantime, which takes two writes during one copy. Neither side takes a lock or disables interrupts.
+template <typename T>
+class JHSSeqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "JHSSeqlock copies T byte for byte");
+
+public:
+    void write(const T &value)
+    {
+        uint32_t sequence = this->sequence_.load(std::memory_order_relaxed);
+        // odd while writing, the active buffer does not change until the write is published
+        this->sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        this->buffers_[((sequence >> 1) + 1) & 1] = value;
+        this->sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    T read() const
+    {
+        T value;
+        uint32_t start;
+        uint32_t end;
+        do
+        {
+            start = this->sequence_.load(std::memory_order_acquire);
+            value = this->buffers_[(start >> 1) & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            end = this->sequence_.load(std::memory_order_relaxed);
+            // the buffer is only overwritten by the write after the next one
+        } while (end - (start & ~1u) > 2);
+        return value;
+    }
+
+    ///@brief Number of completed writes, cheap to poll for changes.
+    uint32_t get_version() const { return this->sequence_.load(std::memory_order_acquire) >> 1; }
+
+protected:
+    std::atomic<uint32_t> sequence_{0};
+    T buffers_[2]{};
+};
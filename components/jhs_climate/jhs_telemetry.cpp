@@ -0,0 +1,76 @@
+#include "jhs_telemetry.h"
+#include <cstring>
+
+static const size_t HEADER_SIZE = 12;
+static const size_t COUNT_OFFSET = 10;
+static const size_t BASE_MS_OFFSET = 6;
+// type, varint (at most 5 bytes), mask and the payload
+static const size_t MAX_RECORD_SIZE = 1 + 5 + 1 + JHS_TELEMETRY_MAX_FRAME;
+
+void JHSTelemetryEncoder::put_u16(size_t offset, uint16_t value)
+{
+    this->buffer_[offset] = value & 0xFF;
+    this->buffer_[offset + 1] = value >> 8;
+}
+
+void JHSTelemetryEncoder::put_u32(size_t offset, uint32_t value)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        this->buffer_[offset + i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+void JHSTelemetryEncoder::reset(uint16_t sequence)
+{
+    this->buffer_[0] = 'J';
+    this->buffer_[1] = 'T';
+    this->buffer_[2] = JHS_TELEMETRY_VERSION;
+    this->buffer_[3] = 0;
+    this->put_u16(4, sequence);
+    this->put_u32(BASE_MS_OFFSET, 0);
+    this->put_u16(COUNT_OFFSET, 0);
+    this->size_ = HEADER_SIZE;
+    this->count_ = 0;
+    memset(this->previous_, 0, sizeof(this->previous_));
+}
+
+bool JHSTelemetryEncoder::add(JHSTelemetryFrameType type, const uint8_t *frame, size_t len, uint32_t now_ms)
+{
+    if (len > JHS_TELEMETRY_MAX_FRAME || this->size_ + MAX_RECORD_SIZE > JHS_TELEMETRY_MAX_DATAGRAM)
+        return false;
+    if (this->count_ == 0)
+    {
+        this->put_u32(BASE_MS_OFFSET, now_ms);
+        this->last_ms_ = now_ms;
+    }
+
+    uint8_t *out = this->buffer_ + this->size_;
+    *out++ = type;
+    uint32_t delta = now_ms - this->last_ms_;
+    do
+    {
+        uint8_t b = delta & 0x7F;
+        delta >>= 7;
+        *out++ = delta ? b | 0x80 : b;
+    } while (delta);
+
+    uint8_t *mask = out++;
+    *mask = 0;
+    uint8_t *previous = this->previous_[type];
+    for (size_t i = 0; i < len; i++)
+    {
+        if (frame[i] != previous[i])
+        {
+            *mask |= 1 << i;
+            *out++ = frame[i];
+            previous[i] = frame[i];
+        }
+    }
+
+    this->size_ = out - this->buffer_;
+    this->last_ms_ = now_ms;
+    this->count_++;
+    this->put_u16(COUNT_OFFSET, this->count_);
+    return true;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// keep datagrams below the usual MTU so they are never fragmented
+const size_t JHS_TELEMETRY_MAX_DATAGRAM = 1400;
+const uint8_t JHS_TELEMETRY_VERSION = 1;
+// largest frame payload (an AC frame without its checksum)
+const size_t JHS_TELEMETRY_MAX_FRAME = 8;
+
+enum JHSTelemetryFrameType : uint8_t
+{
+    JHS_TELEMETRY_AC = 0,
+    JHS_TELEMETRY_PANEL = 1,
+};
+
+///@brief Packs decoded frames into a batched, delta-compressed datagram.
+///
+/// Datagram layout (little endian), decoded by tools/jhs_telemetry_receiver.py:
+///   'J' 'T' version reserved | sequence:u16 | base timestamp ms:u32 | record count:u16 | records...
+/// Record:
+///   type:u8 | ms since the previous record (or the base timestamp):varint | changed byte mask:u8 | changed bytes
+/// Bytes are compared with the previous frame of the same type in the same datagram (zeros for the first one),
+/// so every datagram can be decoded on its own. AC frames are exported only once their checksum was verified,
+/// so it is left out, panel frames are sent whole.
+class JHSTelemetryEncoder
+{
+public:
+    JHSTelemetryEncoder() { this->reset(0); }
+
+    ///@brief Starts a new datagram.
+    void reset(uint16_t sequence);
+
+    ///@brief Appends a frame without its checksum, returns false if the datagram is full.
+    bool add(JHSTelemetryFrameType type, const uint8_t *frame, size_t len, uint32_t now_ms);
+
+    bool empty() const { return this->count_ == 0; }
+    uint16_t get_count() const { return this->count_; }
+    const uint8_t *data() const { return this->buffer_; }
+    size_t size() const { return this->size_; }
+
+protected:
+    void put_u16(size_t offset, uint16_t value);
+    void put_u32(size_t offset, uint32_t value);
+
+    uint8_t buffer_[JHS_TELEMETRY_MAX_DATAGRAM];
+    size_t size_ = 0;
+    uint16_t count_ = 0;
+    uint32_t last_ms_ = 0;
+    uint8_t previous_[2][JHS_TELEMETRY_MAX_FRAME];
+};
@@ -0,0 +1,49 @@
+#include "jhs_thermostat.h"
+#include <cmath>
+
+int JHSThermostat::update(float room, float target, uint32_t now_ms)
+{
+    // a sensor without a reading yet (or a bad target) must not drive the output or end up in the PID history
+    if (!std::isfinite(room) || !std::isfinite(target))
+        return -1;
+
+    // positive when the room is too warm
+    float error = room - target;
+
+    if (this->type_ == JHS_THERMOSTAT_HYSTERESIS)
+    {
+        if (error >= this->hysteresis_)
+            this->cooling_ = true;
+        else if (error <= -this->hysteresis_)
+            this->cooling_ = false;
+        return this->cooling_ ? JHS_AC_MIN_SETPOINT : JHS_AC_MAX_SETPOINT;
+    }
+
+    float dt = this->has_history_ ? (now_ms - this->last_update_ms_) / 1000.0f : 0;
+    float derivative = dt > 0 ? (error - this->last_error_) / dt : 0;
+    float integral = this->integral_ + error * dt;
+    float output = this->kp_ * error + this->ki_ * integral + this->kd_ * derivative;
+    float setpoint = target - output;
+
+    // only integrate while the output is not saturated, so the integral does not wind up
+    if (setpoint >= JHS_AC_MIN_SETPOINT && setpoint <= JHS_AC_MAX_SETPOINT)
+        this->integral_ = integral;
+
+    this->last_error_ = error;
+    this->last_update_ms_ = now_ms;
+    this->has_history_ = true;
+
+    if (setpoint < JHS_AC_MIN_SETPOINT)
+        return JHS_AC_MIN_SETPOINT;
+    if (setpoint > JHS_AC_MAX_SETPOINT)
+        return JHS_AC_MAX_SETPOINT;
+    return (int)std::lround(setpoint);
+}
+
+void JHSThermostat::reset()
+{
+    this->cooling_ = false;
+    this->has_history_ = false;
+    this->integral_ = 0;
+    this->last_error_ = 0;
+}
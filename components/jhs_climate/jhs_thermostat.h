@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+// setpoint range accepted by the AC
+const int JHS_AC_MIN_SETPOINT = 16;
+const int JHS_AC_MAX_SETPOINT = 31;
+
+enum JHSThermostatType : uint8_t
+{
+    JHS_THERMOSTAT_HYSTERESIS = 0,
+    JHS_THERMOSTAT_PID,
+};
+
+///@brief Room temperature controller, regulates the room by moving the setpoint of the AC's own thermostat.
+/// Hysteresis control switches between the lowest (compressor on) and highest (compressor off) setpoint,
+/// PID control offsets the AC setpoint from the target proportionally to the error.
+class JHSThermostat
+{
+public:
+    void set_type(JHSThermostatType type) { this->type_ = type; }
+    JHSThermostatType get_type() const { return this->type_; }
+    void set_hysteresis(float hysteresis) { this->hysteresis_ = hysteresis; }
+    float get_hysteresis() const { return this->hysteresis_; }
+    void set_pid(float kp, float ki, float kd)
+    {
+        this->kp_ = kp;
+        this->ki_ = ki;
+        this->kd_ = kd;
+    }
+
+    ///@brief Returns the AC setpoint for the given room and target temperatures.
+    /// Returns -1 and leaves the controller untouched if either temperature is not finite.
+    int update(float room, float target, uint32_t now_ms);
+
+    ///@brief Forgets the controller history, call when the AC is not cooling.
+    void reset();
+
+protected:
+    JHSThermostatType type_ = JHS_THERMOSTAT_HYSTERESIS;
+    float hysteresis_ = 0.5f;
+    float kp_ = 2.0f;
+    float ki_ = 0.0f;
+    float kd_ = 0.0f;
+
+    bool cooling_ = false;
+    bool has_history_ = false;
+    float integral_ = 0;
+    float last_error_ = 0;
+    uint32_t last_update_ms_ = 0;
+};
@@ -0,0 +1,91 @@
+// Records a random but typical stream of state transitions into a JHSStateHistory and writes the history endpoint
+// body, read in small chunks through JHSHistoryStream, to a file for tools/test_jhs_history_dump.py. After the first
+// chunk another day of transitions is recorded, enough to wrap the ring, which must not change the body being read.
+// Prints every state recorded before the stream was created, one per line:
+//
+//     <uptime s> <flags> <setpoint>
+//
+// followed by a summary line: # <transitions> <bytes in the ring> <Content-Length of the body>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "jhs_history.h"
+
+static const size_t RING_SIZE = 4096;
+static const int TRANSITIONS_PER_DAY = 150;
+static const uint32_t DAY_S = 24 * 60 * 60;
+
+// the state carries over from one day to the next
+static uint8_t flags = JHS_HISTORY_MODE_COOL;
+static int setpoint = 24;
+
+///@brief Records a day of transitions, printing them if asked to.
+static void record_day(JHSStateHistory &history, std::mt19937 &rng, int day, bool print)
+{
+    std::vector<uint32_t> times;
+    for (int i = 0; i < TRANSITIONS_PER_DAY; i++)
+    {
+        times.push_back(day * DAY_S + rng() % DAY_S);
+    }
+    std::sort(times.begin(), times.end());
+    for (uint32_t now : times)
+    {
+        // mostly adjustments starting and ending and setpoint changes, now and then something else
+        int kind = rng() % 20;
+        if (kind < 8)
+            flags ^= JHS_HISTORY_ADJUSTING;
+        else if (kind < 12)
+            setpoint = 16 + (setpoint - 16 + 1 + rng() % 15) % 16;
+        else if (kind < 15)
+            flags = (flags & ~JHS_HISTORY_MODE_MASK) | ((flags & JHS_HISTORY_MODE_MASK) + 1 + rng() % 3) % 4;
+        else if (kind < 17)
+            flags ^= JHS_HISTORY_FAN_HIGH;
+        else if (kind < 19)
+            flags ^= JHS_HISTORY_SLEEP;
+        else
+            flags ^= JHS_HISTORY_WATER_FULL;
+        history.record(flags, setpoint, now);
+        if (print)
+            printf("%u %u %d\n", now, flags, setpoint);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <output> <days>\n", argv[0]);
+        return 2;
+    }
+    int days = atoi(argv[2]);
+
+    JHSStateHistory history;
+    history.init(RING_SIZE);
+    std::mt19937 rng(36);
+    int transitions = 0;
+    for (int day = 0; day < days; day++)
+    {
+        record_day(history, rng, day, true);
+        transitions += TRANSITIONS_PER_DAY;
+    }
+    size_t used = history.get_used();
+
+    JHSHistoryStream stream(&history, days * DAY_S);
+    FILE *out = fopen(argv[1], "wb");
+    uint8_t chunk[100];
+    // the first chunk ends in the middle of the header
+    size_t len = stream.read(chunk, 7);
+    // the ring wraps while the body is sent
+    record_day(history, rng, days, false);
+    while (len > 0)
+    {
+        fwrite(chunk, 1, len, out);
+        len = stream.read(chunk, sizeof(chunk));
+    }
+    fclose(out);
+    printf("# %d %zu %zu\n", transitions, used, stream.get_length());
+    return 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// A model of the AC for the tests which run the whole component: it reacts to the buttons like the real one and
+// reports its state in AC frames.
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "esphome/components/climate/climate.h"
+#include "jhs_packets.h"
+#include "jhs_thermostat.h"
+
+using namespace esphome::climate;
+
+///@brief The AC side of the protocol: applies the buttons pressed on the panel line and reports its state.
+struct AcModel
+{
+    enum Mode
+    {
+        COOL,
+        DRY,
+        FAN,
+    };
+
+    bool on = true;
+    Mode mode = COOL;
+    int setpoint = 24;
+    bool fan_high = false;
+    bool sleep = false;
+    int room = 27;
+
+    void press(const std::vector<uint8_t> &frame)
+    {
+        auto is = [&frame](const std::array<uint8_t, 3> &button) { return std::equal(button.begin(), button.end(), frame.begin()); };
+        if (is(BUTTON_ON))
+            this->on = !this->on;
+        else if (is(BUTTON_FAN))
+            this->fan_high = !this->fan_high;
+        else if (is(BUTTON_SLEEP))
+            this->sleep = !this->sleep;
+        else if (!this->on)
+            return;
+        else if (is(BUTTON_MODE))
+            this->mode = (Mode)((this->mode + 1) % 3);
+        else if (is(BUTTON_LOWER_TEMP) && this->mode == COOL)
+            this->setpoint = std::max(this->setpoint - 1, JHS_AC_MIN_SETPOINT);
+        else if (is(BUTTON_HIGHER_TEMP) && this->mode == COOL)
+            this->setpoint = std::min(this->setpoint + 1, JHS_AC_MAX_SETPOINT);
+    }
+
+    std::vector<uint8_t> frame() const
+    {
+        JHSAcPacket packet;
+        packet.power = this->on;
+        if (this->on)
+        {
+            packet.cool = this->mode == COOL;
+            packet.dehum = this->mode == DRY;
+            packet.fan = this->mode == FAN;
+        }
+        packet.fan_low = !this->fan_high;
+        packet.fan_high = this->fan_high;
+        packet.sleep = this->sleep;
+        // the setpoint in cool mode, the room temperature otherwise
+        packet.set_temp(this->on && this->mode == COOL ? this->setpoint : this->room);
+        return packet.to_wire_format();
+    }
+
+    ClimateMode climate_mode() const
+    {
+        if (!this->on)
+            return CLIMATE_MODE_OFF;
+        const ClimateMode modes[] = {CLIMATE_MODE_COOL, CLIMATE_MODE_DRY, CLIMATE_MODE_FAN_ONLY};
+        return modes[this->mode];
+    }
+    ClimateFanMode climate_fan_mode() const { return this->fan_high ? CLIMATE_FAN_HIGH : CLIMATE_FAN_LOW; }
+    ClimatePreset climate_preset() const { return this->sleep ? CLIMATE_PRESET_SLEEP : CLIMATE_PRESET_NONE; }
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+// Helpers shared by the host tests: a check macro and a model of the AC line driving the real RX interrupt handler.
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "host_stubs.h"
+#include "jhs_frame_decoder.h"
+#include "jhs_packets.h"
+#include "jhs_recv_task.h"
+#include "jhs_rmt_encoder.h"
+
+static int check_failures = 0;
+
+#define CHECK(condition)                                                            \
+    do                                                                              \
+    {                                                                               \
+        if (!(condition))                                                           \
+        {                                                                           \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            check_failures++;                                                       \
+        }                                                                           \
+    } while (0)
+
+///@brief A random but well formed AC frame in wire format: a temperature on the display and a plausible mode.
+inline std::vector<uint8_t> random_ac_frame(std::mt19937 &rng)
+{
+    JHSAcPacket packet;
+    packet.set_temp(16 + rng() % 16);
+    switch (rng() % 5)
+    {
+    case 0:
+        packet.cool = 1;
+        break;
+    case 1:
+        packet.dehum = 1;
+        break;
+    case 2:
+        packet.fan = 1;
+        break;
+    case 3:
+        packet.heat = 1;
+        break;
+    default:
+        packet.power = 0;
+        break;
+    }
+    if (rng() % 2)
+        packet.fan_low = 1;
+    else
+        packet.fan_high = 1;
+    packet.sleep = rng() % 4 == 0;
+    packet.water_full = rng() % 8 == 0;
+    packet.timer = rng() % 8 == 0;
+    packet.beep_amount = rng() % 4 == 0 ? 1 : 0;
+    return packet.to_wire_format();
+}
+
+///@brief Falling edge times of a frame sent like the RMT encoder does it, the first one (the lead-in) at start.
+/// Edge k starts RMT item k, so edge 1 ends the start bit and edge k + 1 ends data bit k - 1.
+inline std::vector<int64_t> frame_edges(const std::vector<uint8_t> &frame, int64_t start)
+{
+    std::vector<rmt_data_t> items(jhs_rmt_items_for(frame.size()));
+    size_t count = jhs_rmt_encode(frame.data(), frame.size(), items.data());
+    std::vector<int64_t> edges;
+    int64_t t = start;
+    for (size_t i = 0; i < count; i++)
+    {
+        edges.push_back(t);
+        t += items[i].duration0 + items[i].duration1;
+    }
+    return edges;
+}
+
+///@brief Bytes of a frame sent as RMT items by jhs_rmt_encode(): a lead-in, the data bits, a lead-out and an end item.
+inline std::vector<uint8_t> rmt_items_frame(const rmt_data_t *items, size_t count)
+{
+    std::vector<uint8_t> frame((count - 3) / 8);
+    for (size_t bit = 0; bit < frame.size() * 8; bit++)
+    {
+        if (items[bit + 1].duration1 > 500)
+            frame[bit / 8] |= 1 << (7 - bit % 8);
+    }
+    return frame;
+}
+
+///@brief Moves the fake clock to each edge and runs the interrupt handler of the pin.
+inline void play_edges(int pin, const std::vector<int64_t> &edges)
+{
+    for (int64_t edge : edges)
+    {
+        host_set_time_us(edge);
+        host_trigger_gpio_isr(pin);
+    }
+}
+
+///@brief Faults injected into a frame on the AC line, one per frame.
+enum Fault
+{
+    FAULT_NONE,
+    // one bit interval ends up within JHS_REPAIR_FLIP_MARGIN_US of the zero/one threshold, on the wrong side
+    FAULT_NEAR_THRESHOLD,
+    FAULT_MISSING_EDGE,
+    // the documented case the decoder cannot repair
+    FAULT_MISSING_EDGE_BETWEEN_ZEROS,
+    FAULT_EXTRA_EDGE,
+    FAULT_TRUNCATED,
+    FAULT_COUNT,
+};
+
+inline bool is_bit_set(const std::vector<uint8_t> &frame, size_t bit)
+{
+    return (frame[bit / 8] >> (7 - bit % 8)) & 1;
+}
+
+///@brief Applies one fault to the edges of a frame (from frame_edges()) which already carry up to jitter_us of jitter.
+inline void inject_fault(Fault fault, const std::vector<uint8_t> &frame, std::vector<int64_t> &edges, int jitter_us, std::mt19937 &rng)
+{
+    // edges[0] is the lead-in, edges[k + 2] ends data bit k
+    switch (fault)
+    {
+    case FAULT_NONE:
+        break;
+    case FAULT_NEAR_THRESHOLD:
+    {
+        size_t bit = rng() % JHS_AC_FRAME_BITS;
+        int64_t start = edges[bit + 1];
+        int64_t offset = 1 + rng() % (JHS_REPAIR_FLIP_MARGIN_US - 1 - jitter_us);
+        int64_t length = is_bit_set(frame, bit) ? JHS_ZERO_MAX_US - offset : JHS_ZERO_MAX_US + offset;
+        // the rest of the frame moves along, only this interval changes
+        int64_t delta = start + length - edges[bit + 2];
+        for (size_t i = bit + 2; i < edges.size(); i++)
+        {
+            edges[i] += delta;
+        }
+        break;
+    }
+    case FAULT_MISSING_EDGE:
+        edges.erase(edges.begin() + 1 + rng() % (edges.size() - 1));
+        break;
+    case FAULT_MISSING_EDGE_BETWEEN_ZEROS:
+    {
+        std::vector<size_t> candidates;
+        for (size_t bit = 0; bit + 1 < JHS_AC_FRAME_BITS; bit++)
+        {
+            if (!is_bit_set(frame, bit) && !is_bit_set(frame, bit + 1))
+                candidates.push_back(bit + 2);
+        }
+        edges.erase(edges.begin() + candidates[rng() % candidates.size()]);
+        break;
+    }
+    case FAULT_EXTRA_EDGE:
+    {
+        size_t i = 1 + rng() % (edges.size() - 2);
+        int64_t at = edges[i] + 1 + rng() % (edges[i + 1] - edges[i] - 1);
+        edges.insert(edges.begin() + i + 1, at);
+        break;
+    }
+    case FAULT_TRUNCATED:
+        edges.resize(2 + rng() % JHS_AC_FRAME_BITS);
+        break;
+    default:
+        break;
+    }
+}
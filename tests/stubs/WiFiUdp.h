@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class IPAddress
+{
+public:
+    bool fromString(const char *address);
+    std::string toString() const { return this->address_; }
+
+protected:
+    std::string address_;
+};
+
+///@brief Counts what would have been sent, see host_udp_datagrams().
+class WiFiUDP
+{
+public:
+    int beginPacket(IPAddress ip, uint16_t port);
+    size_t write(const uint8_t *buffer, size_t size);
+    int endPacket();
+};
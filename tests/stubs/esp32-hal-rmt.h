@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+typedef struct
+{
+    union
+    {
+        struct
+        {
+            uint32_t duration0 : 15;
+            uint32_t level0 : 1;
+            uint32_t duration1 : 15;
+            uint32_t level1 : 1;
+        };
+        uint32_t val;
+    };
+} rmt_data_t;
+
+typedef enum
+{
+    RMT_MEM_64 = 1,
+    RMT_MEM_128 = 2,
+    RMT_MEM_192 = 3,
+} rmt_reserve_memsize_t;
+
+struct rmt_obj_s;
+typedef struct rmt_obj_s rmt_obj_t;
+
+///@brief Takes the next free channel and routes its output signal to the pin through GPIO.
+rmt_obj_t *rmtInit(int pin, bool tx_not_rx, rmt_reserve_memsize_t memsize);
+///@brief The items are kept for host_take_rmt_writes().
+bool rmtWrite(rmt_obj_t *rmt, rmt_data_t *data, size_t size);
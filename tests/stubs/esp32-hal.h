@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include "esp_attr.h"
+#include "esp_err.h"
+
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLDOWN 0x09
+#define FALLING 0x02
+
+struct hw_timer_s;
+typedef struct hw_timer_s hw_timer_t;
+
+unsigned long micros();
+unsigned long millis();
+void pinMode(uint8_t pin, uint8_t mode);
+
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool count_up);
+///@brief The handler is kept for host_fire_timer().
+void timerAttachInterrupt(hw_timer_t *timer, void (*handler)(void), bool edge);
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm_value, bool autoreload);
+void timerAlarmEnable(hw_timer_t *timer);
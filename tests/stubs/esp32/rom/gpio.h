@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+void gpio_matrix_out(uint32_t gpio, uint32_t signal_idx, bool out_inv, bool oen_inv);
+void gpio_matrix_in(uint32_t gpio, uint32_t signal_idx, bool inv);
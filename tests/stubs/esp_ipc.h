@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+#include "esp_err.h"
+
+typedef void (*esp_ipc_func_t)(void *arg);
+
+///@brief Runs the function right away on the calling thread.
+esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void *arg);
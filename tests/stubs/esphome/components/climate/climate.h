@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include "esphome/core/optional.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome
+{
+namespace climate
+{
+
+enum ClimateMode : uint8_t
+{
+    CLIMATE_MODE_OFF = 0,
+    CLIMATE_MODE_HEAT_COOL = 1,
+    CLIMATE_MODE_COOL = 2,
+    CLIMATE_MODE_HEAT = 3,
+    CLIMATE_MODE_FAN_ONLY = 4,
+    CLIMATE_MODE_DRY = 5,
+    CLIMATE_MODE_AUTO = 6,
+};
+
+enum ClimateFanMode : uint8_t
+{
+    CLIMATE_FAN_ON = 0,
+    CLIMATE_FAN_OFF = 1,
+    CLIMATE_FAN_AUTO = 2,
+    CLIMATE_FAN_LOW = 3,
+    CLIMATE_FAN_MEDIUM = 4,
+    CLIMATE_FAN_HIGH = 5,
+};
+
+enum ClimatePreset : uint8_t
+{
+    CLIMATE_PRESET_NONE = 0,
+    CLIMATE_PRESET_HOME = 1,
+    CLIMATE_PRESET_AWAY = 2,
+    CLIMATE_PRESET_BOOST = 3,
+    CLIMATE_PRESET_COMFORT = 4,
+    CLIMATE_PRESET_ECO = 5,
+    CLIMATE_PRESET_SLEEP = 6,
+    CLIMATE_PRESET_ACTIVITY = 7,
+};
+
+class ClimateTraits
+{
+public:
+    void set_supports_current_temperature(bool supports) {}
+    void set_supported_modes(std::initializer_list<ClimateMode> modes) {}
+    void set_supported_fan_modes(std::initializer_list<ClimateFanMode> modes) {}
+    void set_supported_presets(std::initializer_list<ClimatePreset> presets) {}
+    void set_visual_min_temperature(float temperature) {}
+    void set_visual_max_temperature(float temperature) {}
+    void set_visual_temperature_step(float step) {}
+};
+
+class Climate;
+
+///@brief The part of the state ESPHome saves to flash with every publish_state().
+struct ClimateDeviceRestoreState
+{
+    ClimateMode mode;
+    float target_temperature;
+};
+
+class ClimateCall
+{
+public:
+    explicit ClimateCall(Climate *parent) : parent_(parent) {}
+
+    ClimateCall &set_mode(ClimateMode mode)
+    {
+        this->mode_ = mode;
+        return *this;
+    }
+    ClimateCall &set_target_temperature(float target_temperature)
+    {
+        this->target_temperature_ = target_temperature;
+        return *this;
+    }
+    ClimateCall &set_fan_mode(ClimateFanMode fan_mode)
+    {
+        this->fan_mode_ = fan_mode;
+        return *this;
+    }
+    ClimateCall &set_preset(ClimatePreset preset)
+    {
+        this->preset_ = preset;
+        return *this;
+    }
+    void perform();
+
+    const optional<ClimateMode> &get_mode() const { return this->mode_; }
+    const optional<float> &get_target_temperature() const { return this->target_temperature_; }
+    const optional<ClimateFanMode> &get_fan_mode() const { return this->fan_mode_; }
+    const optional<ClimatePreset> &get_preset() const { return this->preset_; }
+
+protected:
+    Climate *parent_;
+    optional<ClimateMode> mode_;
+    optional<float> target_temperature_;
+    optional<ClimateFanMode> fan_mode_;
+    optional<ClimatePreset> preset_;
+};
+
+class Climate
+{
+public:
+    virtual ~Climate() = default;
+
+    ClimateCall make_call() { return ClimateCall(this); }
+    void publish_state()
+    {
+        this->publish_count++;
+        ClimateDeviceRestoreState state = {this->mode, this->target_temperature};
+        global_preferences->make_preference<ClimateDeviceRestoreState>(this->get_object_id_hash()).save(&state);
+    }
+    uint32_t get_object_id_hash() const { return 0x4A485343; }
+
+    ClimateMode mode = CLIMATE_MODE_OFF;
+    optional<ClimateFanMode> fan_mode;
+    optional<ClimatePreset> preset;
+    float current_temperature = NAN;
+    float target_temperature = NAN;
+    uint32_t publish_count = 0;
+
+protected:
+    friend ClimateCall;
+    virtual ClimateTraits traits() = 0;
+    virtual void control(const ClimateCall &call) = 0;
+
+    optional<ClimateDeviceRestoreState> restore_state_()
+    {
+        ClimateDeviceRestoreState state;
+        if (!global_preferences->make_preference<ClimateDeviceRestoreState>(this->get_object_id_hash()).load(&state))
+            return {};
+        return state;
+    }
+};
+
+inline void ClimateCall::perform() { this->parent_->control(*this); }
+
+}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+namespace esphome
+{
+namespace sensor
+{
+
+class Sensor
+{
+public:
+    void publish_state(float state)
+    {
+        this->state = state;
+        this->has_state_ = true;
+        for (auto &callback : this->callbacks_)
+        {
+            callback(state);
+        }
+    }
+    bool has_state() const { return this->has_state_; }
+    void add_on_state_callback(std::function<void(float)> &&callback) { this->callbacks_.push_back(std::move(callback)); }
+
+    float state = NAN;
+
+protected:
+    bool has_state_ = false;
+    std::vector<std::function<void(float)>> callbacks_;
+};
+
+}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+namespace esphome
+{
+namespace wifi
+{
+
+class WiFiComponent
+{
+public:
+    bool is_connected() const { return this->connected; }
+    bool connected = true;
+};
+
+extern WiFiComponent *global_wifi_component;
+
+}
+}
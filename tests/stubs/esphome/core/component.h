@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome
+{
+
+class Component
+{
+public:
+    virtual ~Component() = default;
+    virtual void setup() {}
+    virtual void loop() {}
+    virtual void dump_config() {}
+    virtual void on_shutdown() {}
+};
+
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+// the history web handler (USE_JHS_HISTORY) needs the web server, which the host tests do not have
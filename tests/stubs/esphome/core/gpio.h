@@ -0,0 +1,18 @@
+#pragma once
+
+#define LOG_PIN(prefix, pin) host_log(TAG, prefix, pin)
+
+namespace esphome
+{
+
+class InternalGPIOPin
+{
+public:
+    explicit InternalGPIOPin(int pin) : pin_(pin) {}
+    int get_pin() const { return this->pin_; }
+
+protected:
+    int pin_;
+};
+
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome
+{
+uint32_t millis();
+uint32_t micros();
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+#define YESNO(b) ((b) ? "YES" : "NO")
@@ -0,0 +1,12 @@
+#pragma once
+
+// logging is compiled out on the host, the arguments are still evaluated
+template <typename... Args> inline void host_log(const char *tag, const char *format, Args... args) {}
+
+#define ESP_LOGE(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGVV(tag, ...) host_log(tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) host_log(tag, __VA_ARGS__)
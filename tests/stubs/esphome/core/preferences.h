@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace esphome
+{
+
+///@brief Kept in memory for the lifetime of the test.
+class ESPPreferenceObject
+{
+public:
+    ESPPreferenceObject() = default;
+    explicit ESPPreferenceObject(std::vector<uint8_t> *data) : data_(data) {}
+
+    template <typename T> bool save(const T *src)
+    {
+        if (this->data_ == nullptr)
+            return false;
+        this->data_->assign((const uint8_t *) src, (const uint8_t *) src + sizeof(T));
+        return true;
+    }
+
+    template <typename T> bool load(T *dest)
+    {
+        if (this->data_ == nullptr || this->data_->size() != sizeof(T))
+            return false;
+        memcpy(dest, this->data_->data(), sizeof(T));
+        return true;
+    }
+
+protected:
+    std::vector<uint8_t> *data_ = nullptr;
+};
+
+class ESPPreferences
+{
+public:
+    template <typename T> ESPPreferenceObject make_preference(uint32_t type) { return ESPPreferenceObject(&this->data_[type]); }
+
+protected:
+    std::map<uint32_t, std::vector<uint8_t>> data_;
+};
+
+extern ESPPreferences *global_preferences;
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define errQUEUE_FULL 0
+#define portMAX_DELAY 0xFFFFFFFF
+
+// the fake ISRs run on the test's thread, critical sections have nothing to exclude
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) (void) (mux)
+#define portEXIT_CRITICAL(mux) (void) (mux)
+#define portENTER_CRITICAL_SAFE(mux) (void) (mux)
+#define portEXIT_CRITICAL_SAFE(mux) (void) (mux)
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include "freertos/FreeRTOS.h"
+
+struct QueueDefinition;
+typedef QueueDefinition *QueueHandle_t;
+
+extern "C" {
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+}
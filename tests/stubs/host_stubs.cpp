@@ -0,0 +1,222 @@
+#include "host_stubs.h"
+#include <cstring>
+#include <deque>
+#include <map>
+#include <vector>
+#include "esp_timer.h"
+#include "esp_ipc.h"
+#include "esp32-hal.h"
+#include "esphome/core/hal.h"
+#include "driver/gpio.h"
+#include "esp32/rom/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/gpio_struct.h"
+#include "soc/rmt_struct.h"
+#include "WiFiUdp.h"
+#include "esphome/core/preferences.h"
+#include "esphome/components/wifi/wifi_component.h"
+
+static int64_t now_us = 0;
+
+void host_set_time_us(int64_t now) { now_us = now; }
+void host_advance_time_us(int64_t duration) { now_us += duration; }
+int64_t host_time_us() { return now_us; }
+
+int64_t esp_timer_get_time() { return now_us; }
+unsigned long micros() { return now_us; }
+unsigned long millis() { return now_us / 1000; }
+namespace esphome
+{
+uint32_t millis() { return now_us / 1000; }
+uint32_t micros() { return now_us; }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {}
+
+struct HostIsrHandler
+{
+    gpio_isr_t handler;
+    void *arg;
+};
+static std::map<int, HostIsrHandler> isr_handlers;
+
+// the Arduino loop task runs on core 1, esp_ipc_call_blocking() moves the caller to another core for the call
+static uint32_t current_core = 1;
+static int gpio_isr_core = -1;
+
+esp_err_t gpio_install_isr_service(int flags)
+{
+    // the service allocates its interrupt on the core it is installed from
+    if (gpio_isr_core >= 0)
+        return ESP_ERR_INVALID_STATE;
+    gpio_isr_core = current_core;
+    return ESP_OK;
+}
+
+int host_gpio_isr_core() { return gpio_isr_core; }
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type) { return ESP_OK; }
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t handler, void *arg)
+{
+    isr_handlers[pin] = {handler, arg};
+    return ESP_OK;
+}
+
+bool host_trigger_gpio_isr(int pin)
+{
+    auto it = isr_handlers.find(pin);
+    if (it == isr_handlers.end())
+        return false;
+    it->second.handler(it->second.arg);
+    return true;
+}
+
+gpio_dev_t GPIO = []() {
+    gpio_dev_t gpio = {};
+    for (auto &out : gpio.func_out_sel_cfg)
+    {
+        out.func_sel = SIG_GPIO_OUT_IDX;
+    }
+    return gpio;
+}();
+
+void gpio_matrix_out(uint32_t gpio, uint32_t signal_idx, bool out_inv, bool oen_inv) { GPIO.func_out_sel_cfg[gpio].func_sel = signal_idx; }
+void gpio_matrix_in(uint32_t gpio, uint32_t signal_idx, bool inv) {}
+
+rmt_dev_t RMT = {};
+rmt_mem_t RMTMEM = {};
+
+struct rmt_obj_s
+{
+    int pin;
+    int channel;
+};
+static int rmt_channels_used = 0;
+static std::map<int, std::vector<HostRmtWrite>> rmt_writes;
+
+rmt_obj_t *rmtInit(int pin, bool tx_not_rx, rmt_reserve_memsize_t memsize)
+{
+    // every channel takes memsize blocks of channel memory, tests which set up the component more than once reuse them
+    if (rmt_channels_used + memsize > 8)
+        rmt_channels_used = 0;
+    rmt_obj_t *rmt = new rmt_obj_t{pin, rmt_channels_used};
+    rmt_channels_used += memsize;
+    gpio_matrix_out(pin, RMT_SIG_OUT0_IDX + rmt->channel, false, false);
+    return rmt;
+}
+
+bool rmtWrite(rmt_obj_t *rmt, rmt_data_t *data, size_t size)
+{
+    rmt_writes[rmt->pin].push_back({now_us, std::vector<rmt_data_t>(data, data + size)});
+    return true;
+}
+
+std::vector<HostRmtWrite> host_take_rmt_writes(int pin)
+{
+    std::vector<HostRmtWrite> writes;
+    writes.swap(rmt_writes[pin]);
+    return writes;
+}
+
+struct hw_timer_s
+{
+    void (*handler)(void) = nullptr;
+    bool edge = false;
+    uint64_t alarm = 0;
+    bool enabled = false;
+};
+static hw_timer_t host_timer;
+
+hw_timer_t *timerBegin(uint8_t num, uint16_t divider, bool count_up) { return &host_timer; }
+
+void timerAttachInterrupt(hw_timer_t *timer, void (*handler)(void), bool edge)
+{
+    timer->handler = handler;
+    timer->edge = edge;
+}
+
+void timerAlarmWrite(hw_timer_t *timer, uint64_t alarm_value, bool autoreload) { timer->alarm = alarm_value; }
+void timerAlarmEnable(hw_timer_t *timer) { timer->enabled = true; }
+
+bool host_fire_timer()
+{
+    if (!host_timer.enabled || host_timer.handler == nullptr)
+        return false;
+    host_timer.handler();
+    return true;
+}
+
+uint64_t host_timer_alarm() { return host_timer.alarm; }
+bool host_timer_level_interrupt() { return !host_timer.edge; }
+
+static size_t udp_datagrams = 0;
+
+bool IPAddress::fromString(const char *address)
+{
+    this->address_ = address;
+    return !this->address_.empty();
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) { return 1; }
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) { return size; }
+
+int WiFiUDP::endPacket()
+{
+    udp_datagrams++;
+    return 1;
+}
+
+size_t host_udp_datagrams() { return udp_datagrams; }
+
+namespace esphome
+{
+static ESPPreferences preferences;
+ESPPreferences *global_preferences = &preferences;
+namespace wifi
+{
+static WiFiComponent wifi_component;
+WiFiComponent *global_wifi_component = &wifi_component;
+}
+}
+
+esp_err_t esp_ipc_call_blocking(uint32_t cpu_id, esp_ipc_func_t func, void *arg)
+{
+    uint32_t caller_core = current_core;
+    current_core = cpu_id;
+    func(arg);
+    current_core = caller_core;
+    return ESP_OK;
+}
+
+struct QueueDefinition
+{
+    size_t length;
+    size_t item_size;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) { return new QueueDefinition{length, item_size, {}}; }
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    if (queue->items.size() >= queue->length)
+        return errQUEUE_FULL;
+    const uint8_t *bytes = (const uint8_t *) item;
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    if (queue->items.empty())
+        return pdFALSE;
+    memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) { return queue->items.size(); }
+
+size_t host_queue_count(void *queue) { return ((QueueHandle_t) queue)->items.size(); }
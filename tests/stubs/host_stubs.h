@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "esp32-hal-rmt.h"
+
+// Controls for the host fakes of the ESP-IDF and Arduino APIs the component uses.
+
+///@brief The fake esp_timer/millis()/micros() clock, it only moves when a test moves it.
+void host_set_time_us(int64_t now);
+void host_advance_time_us(int64_t duration);
+int64_t host_time_us();
+
+///@brief Calls the interrupt handler bound to the pin with gpio_isr_handler_add(), as if a falling edge happened now.
+/// Returns false if no handler is bound.
+bool host_trigger_gpio_isr(int pin);
+
+///@brief Core the GPIO ISR service was installed from, which runs all GPIO interrupts. -1 if it was not installed.
+int host_gpio_isr_core();
+
+struct HostRmtWrite
+{
+    int64_t time_us;
+    std::vector<rmt_data_t> items;
+};
+
+///@brief Returns and forgets the rmtWrite() calls made for the channel driving the pin, oldest first.
+std::vector<HostRmtWrite> host_take_rmt_writes(int pin);
+
+///@brief Runs the handler attached with timerAttachInterrupt(), as if the alarm fired now.
+/// Returns false if there is no enabled alarm.
+bool host_fire_timer();
+///@brief Alarm period set with timerAlarmWrite(), in timer ticks.
+uint64_t host_timer_alarm();
+///@brief True if the handler was attached for a level interrupt, edge ones are unreliable on the ESP32.
+bool host_timer_level_interrupt();
+
+///@brief Datagrams sent with WiFiUDP so far.
+size_t host_udp_datagrams();
+
+///@brief Number of items currently waiting in a queue created with xQueueCreate().
+size_t host_queue_count(void *queue);
@@ -0,0 +1,3 @@
+#pragma once
+
+// power management is left disabled, JHSPowerLock only does its bookkeeping on the host
@@ -0,0 +1,6 @@
+#pragma once
+
+#define RMT_SIG_OUT0_IDX 87
+#define SIG_IN_FUNC224_IDX 224
+#define SIG_IN_FUNC225_IDX 225
+#define SIG_GPIO_OUT_IDX 256
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+typedef struct
+{
+    struct
+    {
+        uint32_t func_sel;
+        uint32_t inv_sel;
+        uint32_t oen_sel;
+        uint32_t oen_inv_sel;
+    } func_out_sel_cfg[40];
+} gpio_dev_t;
+
+///@brief Written by rmtInit() and gpio_matrix_out() like the real GPIO matrix.
+extern gpio_dev_t GPIO;
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+typedef struct
+{
+    struct
+    {
+        struct
+        {
+            uint32_t div_cnt;
+            uint32_t idle_thres;
+            uint32_t mem_size;
+        } conf0;
+        struct
+        {
+            uint32_t tx_start;
+            uint32_t rx_en;
+            uint32_t mem_wr_rst;
+            uint32_t mem_rd_rst;
+            uint32_t ref_always_on;
+            uint32_t idle_out_lv;
+            uint32_t idle_out_en;
+        } conf1;
+    } conf_ch[8];
+} rmt_dev_t;
+
+typedef struct
+{
+    struct
+    {
+        union
+        {
+            struct
+            {
+                uint32_t duration0 : 15;
+                uint32_t level0 : 1;
+                uint32_t duration1 : 15;
+                uint32_t level1 : 1;
+            };
+            uint32_t val;
+        } data32[64];
+    } chan[8];
+} rmt_mem_t;
+
+extern rmt_dev_t RMT;
+extern rmt_mem_t RMTMEM;
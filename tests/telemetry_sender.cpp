@@ -0,0 +1,120 @@
+// Feeds a steady stream of AC and panel frames through JHSTelemetryEncoder and sends the datagrams over UDP, for
+// tools/test_jhs_telemetry_receiver.py. Prints every frame that made it into a datagram, one per line:
+//
+//     <timestamp ms> ac|panel <frame hex, AC frames with their checksum>
+//
+// followed by a summary line: # <frames> <datagrams> <bytes> <ns of encoding per frame>
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "jhs_packets.h"
+#include "jhs_telemetry.h"
+
+struct SentFrame
+{
+    uint32_t timestamp;
+    JHSTelemetryFrameType type;
+    std::vector<uint8_t> frame;
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <port> [frames]\n", argv[0]);
+        return 2;
+    }
+    int port = atoi(argv[1]);
+    int total = argc > 2 ? atoi(argv[2]) : 20000;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::mt19937 rng(33);
+    JHSAcPacket ac;
+    ac.cool = 1;
+    ac.fan_low = 1;
+    ac.set_temp(24);
+
+    JHSTelemetryEncoder encoder;
+    uint16_t sequence = 0;
+    encoder.reset(sequence);
+    std::vector<SentFrame> pending;
+    std::chrono::nanoseconds encoding(0);
+    int frames = 0;
+    int datagrams = 0;
+    size_t bytes = 0;
+
+    // start just before millis() wraps, the receiver must carry the timestamps over
+    uint32_t now = 0xFFFFFFFF - 5000;
+    uint32_t last_flush = now;
+    for (int i = 0; i < total; i++)
+    {
+        // the panel sends a keepalive and the AC answers with its state, roughly every 100 ms
+        now += 90 + rng() % 20;
+        SentFrame sent;
+        sent.timestamp = now;
+        if (i % 2 == 0)
+        {
+            sent.type = JHS_TELEMETRY_PANEL;
+            sent.frame.assign(KEEPALIVE_PACKET.begin(), KEEPALIVE_PACKET.end());
+            if (rng() % 200 == 0)
+                sent.frame.assign(BUTTON_LOWER_TEMP.begin(), BUTTON_LOWER_TEMP.end());
+        }
+        else
+        {
+            // an occasional change of the setpoint or the fan speed
+            if (rng() % 100 == 0)
+                ac.set_temp(16 + rng() % 16);
+            if (rng() % 300 == 0)
+            {
+                ac.fan_low ^= 1;
+                ac.fan_high ^= 1;
+            }
+            sent.type = JHS_TELEMETRY_AC;
+            sent.frame = ac.to_wire_format();
+        }
+
+        // the same call the component makes, AC frames without their checksum
+        size_t len = sent.type == JHS_TELEMETRY_AC ? sent.frame.size() - 1 : sent.frame.size();
+        auto start = std::chrono::steady_clock::now();
+        bool added = encoder.add(sent.type, sent.frame.data(), len, now);
+        encoding += std::chrono::steady_clock::now() - start;
+        if (added)
+            pending.push_back(sent);
+
+        if (now - last_flush >= 1000 || i == total - 1)
+        {
+            sendto(sock, encoder.data(), encoder.size(), 0, (sockaddr *) &address, sizeof(address));
+            frames += encoder.get_count();
+            datagrams++;
+            bytes += encoder.size();
+            for (const SentFrame &frame : pending)
+            {
+                printf("%u %s ", frame.timestamp, frame.type == JHS_TELEMETRY_AC ? "ac" : "panel");
+                for (uint8_t b : frame.frame)
+                {
+                    printf("%02x", b);
+                }
+                printf("\n");
+            }
+            pending.clear();
+            encoder.reset(++sequence);
+            last_flush = now;
+            // do not outrun the receiver's socket buffer
+            usleep(200);
+        }
+    }
+    close(sock);
+    printf("# %d %d %zu %.1f\n", frames, datagrams, bytes, (double) encoding.count() / total);
+    return 0;
+}
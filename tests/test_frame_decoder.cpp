@@ -0,0 +1,113 @@
+// Fault injection harness for the AC receive path: synthetic frames are played edge by edge through the real
+// RX interrupt handler, with ISR latency jitter and one injected fault per frame, and the queued frames are decoded
+// by jhs_decode_ac_frame(). Fails if the share of correct frames drops or the share of wrong frames grows past
+// the thresholds below.
+
+#include <cstring>
+#include "jhs_test.h"
+#include "jhs_frame_decoder.h"
+#include "jhs_recv_task.h"
+
+static const int AC_RX_PIN = 4;
+static const int TRIALS = 20000;
+// latency of the edge interrupt, every edge is moved by up to this much
+static const int JITTER_US = 40;
+static const int64_t FRAME_PERIOD_US = 100000;
+
+struct Threshold
+{
+    const char *name;
+    // minimum share of frames decoded to exactly what was sent
+    double min_correct;
+    // maximum share of frames decoded to something that was not sent
+    double max_wrong;
+};
+
+// measured with the seed below and rounded down (up for wrong frames), so a regression in the decoder fails the test.
+// Wrong frames are nearly all frames whose shifted bits happen to pass the checksum without any repair.
+static const Threshold THRESHOLDS[FAULT_COUNT] = {
+    {"none", 1.0, 0.0},
+    {"near threshold", 0.98, 0.0},
+    {"missing edge", 0.40, 0.0015},
+    {"missing edge 0+0", 0.0, 0.0025},
+    {"extra edge", 0.90, 0.0010},
+    {"truncated", 0.0, 0.0},
+};
+
+struct Outcome
+{
+    int correct = 0;
+    int wrong = 0;
+    int dropped = 0;
+    int valid = 0;
+    int repaired = 0;
+};
+
+static Outcome run(Fault fault, std::mt19937 &rng)
+{
+    Outcome outcome;
+    std::uniform_int_distribution<int> jitter(-JITTER_US, JITTER_US);
+    for (int trial = 0; trial < TRIALS; trial++)
+    {
+        std::vector<uint8_t> sent = random_ac_frame(rng);
+        std::vector<int64_t> edges = frame_edges(sent, host_time_us() + FRAME_PERIOD_US);
+        for (int64_t &edge : edges)
+        {
+            edge += jitter(rng);
+        }
+        inject_fault(fault, sent, edges, JITTER_US, rng);
+        play_edges(AC_RX_PIN, edges);
+        host_advance_time_us(FRAME_PERIOD_US);
+
+        bool correct = false;
+        bool wrong = false;
+        jhs_ac_rx_frame rx;
+        while (xQueueReceive(ac_rx_queue, &rx, 0))
+        {
+            uint8_t decoded[JHS_AC_PACKET_SIZE];
+            JHSDecodeResult result = jhs_decode_ac_frame(rx, decoded);
+            if (result == JHS_DECODE_UNRECOVERABLE)
+                continue;
+            if (result == JHS_DECODE_VALID)
+                outcome.valid++;
+            else
+                outcome.repaired++;
+            if (memcmp(decoded, sent.data(), JHS_AC_PACKET_SIZE) == 0)
+                correct = true;
+            else
+                wrong = true;
+        }
+        if (wrong)
+            outcome.wrong++;
+        else if (correct)
+            outcome.correct++;
+        else
+            outcome.dropped++;
+    }
+    return outcome;
+}
+
+int main()
+{
+    jhs_recv_task_config config = {AC_RX_PIN, -1, 6, 7, false};
+    start_jhs_climate_recv_task(config);
+    // the RX interrupts run on core 0, away from the main loop
+    CHECK(host_gpio_isr_core() == 0);
+    std::mt19937 rng(30);
+
+    printf("%-18s %8s %8s %8s %8s %8s\n", "fault", "correct", "wrong", "dropped", "valid", "repaired");
+    for (int fault = 0; fault < FAULT_COUNT; fault++)
+    {
+        Outcome outcome = run((Fault) fault, rng);
+        const Threshold &threshold = THRESHOLDS[fault];
+        double correct = (double) outcome.correct / TRIALS;
+        double wrong = (double) outcome.wrong / TRIALS;
+        printf("%-18s %7.2f%% %7.3f%% %7.2f%% %8d %8d\n", threshold.name, 100 * correct, 100 * wrong,
+               100.0 * outcome.dropped / TRIALS, outcome.valid, outcome.repaired);
+        CHECK(correct >= threshold.min_correct);
+        CHECK(wrong <= threshold.max_wrong);
+    }
+    // every frame fit the queue, nothing counted as an overflow
+    CHECK(jhs_rx_queue_overflows() == 0);
+    return check_failures == 0 ? 0 : 1;
+}
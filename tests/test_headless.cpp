@@ -0,0 +1,148 @@
+// Headless mode: the keepalive timer is driven by hand with the fake clock and the frames it writes into the RMT
+// channel memory are decoded back. Checks the interrupt type, the cadence and content of the keepalives, the
+// single press slot, that a tick is skipped while the previous frame is still on the wire, and that the component
+// only counts a button press as done once the slot took it.
+
+#include "jhs_test.h"
+#include "jhs_ac_model.h"
+#include "jhs_climate.h"
+#include "jhs_headless.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/gpio_struct.h"
+#include "soc/rmt_struct.h"
+
+static const int AC_RX_PIN = 4;
+static const int AC_TX_PIN = 5;
+static const uint32_t KEEPALIVE_INTERVAL_MS = 100;
+static const int64_t INTERVAL_US = KEEPALIVE_INTERVAL_MS * 1000;
+// latency of the timer interrupt
+static const int ISR_LATENCY_US = 200;
+// the AC answers a panel frame this long after it started
+static const int64_t AC_FRAME_OFFSET_US = 30000;
+
+static const std::vector<uint8_t> KEEPALIVE(KEEPALIVE_PACKET.begin(), KEEPALIVE_PACKET.end());
+
+static int rmt_channel()
+{
+    return GPIO.func_out_sel_cfg[AC_TX_PIN].func_sel - RMT_SIG_OUT0_IDX;
+}
+
+///@brief Fires the timer at the given time and returns the frame it started, empty if it started none.
+static std::vector<uint8_t> tick(int64_t at)
+{
+    int channel = rmt_channel();
+    host_set_time_us(at);
+    // the hardware clears tx_start once the transmission started
+    RMT.conf_ch[channel].conf1.tx_start = 0;
+    CHECK(host_fire_timer());
+    if (!RMT.conf_ch[channel].conf1.tx_start)
+        return {};
+    rmt_data_t items[64];
+    size_t count = 0;
+    while (RMTMEM.chan[channel].data32[count].val != 0)
+    {
+        items[count].val = RMTMEM.chan[channel].data32[count].val;
+        count++;
+    }
+    return rmt_items_frame(items, count);
+}
+
+static void test_timer()
+{
+    // Arduino only delivers level interrupts of the timer group reliably, at 1 us per tick
+    CHECK(host_timer_level_interrupt());
+    CHECK(host_timer_alarm() == INTERVAL_US);
+}
+
+static void test_cadence(int64_t &now, std::mt19937 &rng)
+{
+    uint32_t sent = jhs_headless_frames_sent();
+    for (int i = 0; i < 1000; i++)
+    {
+        now += INTERVAL_US;
+        CHECK(tick(now + rng() % ISR_LATENCY_US) == KEEPALIVE);
+    }
+    CHECK(jhs_headless_frames_sent() - sent == 1000);
+    CHECK(jhs_headless_max_jitter_us() < ISR_LATENCY_US);
+}
+
+static void test_press_slot(int64_t &now)
+{
+    CHECK(jhs_headless_ready());
+    CHECK(jhs_headless_send(BUTTON_FAN.data()));
+    // one press at a time, the second one has to wait for the next tick
+    CHECK(!jhs_headless_ready());
+    CHECK(!jhs_headless_send(BUTTON_MODE.data()));
+    now += INTERVAL_US;
+    CHECK(tick(now) == std::vector<uint8_t>(BUTTON_FAN.begin(), BUTTON_FAN.end()));
+    CHECK(jhs_headless_ready());
+    now += INTERVAL_US;
+    CHECK(tick(now) == KEEPALIVE);
+}
+
+static void test_busy_channel(int64_t &now)
+{
+    uint32_t sent = jhs_headless_frames_sent();
+    now += INTERVAL_US;
+    CHECK(tick(now) == KEEPALIVE);
+    // a late interrupt followed by an early one, the keepalive takes about 23 ms and is still being sent
+    CHECK(tick(now + 15000).empty());
+    now += INTERVAL_US;
+    CHECK(tick(now) == KEEPALIVE);
+    CHECK(jhs_headless_frames_sent() - sent == 2);
+}
+
+///@brief One keepalive period: the timer sends a frame, the AC answers it and the main loop runs once.
+static void run_periods(esphome::JHSClimate::JHSClimate &climate, AcModel &ac, int64_t &now, int periods)
+{
+    for (int i = 0; i < periods; i++)
+    {
+        now += INTERVAL_US;
+        std::vector<uint8_t> frame = tick(now);
+        CHECK(!frame.empty());
+        ac.press(frame);
+        play_edges(AC_RX_PIN, frame_edges(ac.frame(), now + AC_FRAME_OFFSET_US));
+        host_set_time_us(now + INTERVAL_US - 3000);
+        climate.loop();
+    }
+}
+
+static void test_presses(esphome::JHSClimate::JHSClimate &climate, int64_t &now)
+{
+    AcModel ac;
+    // the component learns the state of the AC first
+    run_periods(climate, ac, now, 5);
+    uint32_t failures = climate.get_health().convergence_failures;
+    // a temperature and a fan speed in one call, the presses compete for the single slot
+    ClimateCall call = climate.make_call();
+    call.set_target_temperature(27);
+    call.set_fan_mode(CLIMATE_FAN_HIGH);
+    call.perform();
+    run_periods(climate, ac, now, 50);
+    CHECK(ac.setpoint == 27);
+    CHECK(ac.fan_high);
+    CHECK(climate.get_health().convergence_failures == failures);
+}
+
+int main()
+{
+    std::mt19937 rng(35);
+    esphome::InternalGPIOPin ac_tx_pin(AC_TX_PIN);
+    esphome::InternalGPIOPin ac_rx_pin(AC_RX_PIN);
+    esphome::binary_sensor::BinarySensor water_full_sensor;
+    esphome::JHSClimate::JHSClimate climate;
+    climate.set_ac_tx_pin(&ac_tx_pin);
+    climate.set_ac_rx_pin(&ac_rx_pin);
+    climate.set_water_full_sensor(&water_full_sensor);
+    climate.set_keepalive_interval(KEEPALIVE_INTERVAL_MS);
+    int64_t now = 1000000;
+    host_set_time_us(now);
+    climate.setup();
+
+    test_timer();
+    test_cadence(now, rng);
+    test_press_slot(now);
+    test_busy_channel(now);
+    test_presses(climate, now);
+    return check_failures == 0 ? 0 : 1;
+}
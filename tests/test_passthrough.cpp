@@ -0,0 +1,128 @@
+// Passthrough fallback on a receive queue overflow: each line is only connected through the GPIO matrix at the start
+// of its own next frame, never in the middle of a frame, and not at all once the main loop drains the queues again.
+
+#include <algorithm>
+#include "jhs_test.h"
+#include "jhs_climate.h"
+#include "jhs_passthrough.h"
+#include "soc/gpio_struct.h"
+
+static const int AC_RX_PIN = 4;
+static const int AC_TX_PIN = 5;
+static const int PANEL_RX_PIN = 6;
+static const int PANEL_TX_PIN = 7;
+static const int64_t FRAME_PERIOD_US = 100000;
+
+static const std::vector<uint8_t> KEEPALIVE(KEEPALIVE_PACKET.begin(), KEEPALIVE_PACKET.end());
+
+static bool ac_to_panel_passthrough()
+{
+    return GPIO.func_out_sel_cfg[PANEL_TX_PIN].func_sel == JHS_AC_TO_PANEL_SIGNAL;
+}
+
+static bool panel_to_ac_passthrough()
+{
+    return GPIO.func_out_sel_cfg[AC_TX_PIN].func_sel == JHS_PANEL_TO_AC_SIGNAL;
+}
+
+///@brief Plays AC frames without running the main loop until the receive queue is one frame short of overflowing.
+static void fill_ac_queue(int64_t &now, std::mt19937 &rng)
+{
+    uint32_t overflows = jhs_rx_queue_overflows();
+    for (int i = 0; i < 16; i++)
+    {
+        play_edges(AC_RX_PIN, frame_edges(random_ac_frame(rng), now));
+        now += FRAME_PERIOD_US;
+    }
+    CHECK(jhs_rx_queue_overflows() == overflows);
+}
+
+static void test_fallback_on_frame_boundary(int64_t &now, std::mt19937 &rng)
+{
+    CHECK(!ac_to_panel_passthrough());
+    CHECK(!panel_to_ac_passthrough());
+    fill_ac_queue(now, rng);
+
+    // the AC frame which overflows the queue ends while the panel is sending
+    std::vector<int64_t> ac_edges = frame_edges(random_ac_frame(rng), now);
+    std::vector<int64_t> panel_edges = frame_edges(KEEPALIVE, ac_edges[JHS_AC_FRAME_BITS] - 5000);
+    std::vector<std::pair<int64_t, int>> events;
+    for (int64_t edge : ac_edges)
+        events.push_back({edge, AC_RX_PIN});
+    for (int64_t edge : panel_edges)
+        events.push_back({edge, PANEL_RX_PIN});
+    std::sort(events.begin(), events.end());
+    uint32_t overflows = jhs_rx_queue_overflows();
+    for (const auto &event : events)
+    {
+        host_set_time_us(event.first);
+        host_trigger_gpio_isr(event.second);
+        CHECK(!ac_to_panel_passthrough());
+        CHECK(!panel_to_ac_passthrough());
+    }
+    CHECK(jhs_rx_queue_overflows() == overflows + 1);
+
+    // the next AC frame is forwarded from its first edge on, the panel line waits for its own next frame
+    now += FRAME_PERIOD_US;
+    ac_edges = frame_edges(random_ac_frame(rng), now);
+    host_set_time_us(ac_edges[0]);
+    host_trigger_gpio_isr(AC_RX_PIN);
+    CHECK(ac_to_panel_passthrough());
+    CHECK(!panel_to_ac_passthrough());
+    play_edges(AC_RX_PIN, std::vector<int64_t>(ac_edges.begin() + 1, ac_edges.end()));
+    CHECK(!panel_to_ac_passthrough());
+    panel_edges = frame_edges(KEEPALIVE, ac_edges.back() + 20000);
+    host_set_time_us(panel_edges[0]);
+    host_trigger_gpio_isr(PANEL_RX_PIN);
+    CHECK(panel_to_ac_passthrough());
+    play_edges(PANEL_RX_PIN, std::vector<int64_t>(panel_edges.begin() + 1, panel_edges.end()));
+    now = panel_edges.back();
+}
+
+static void test_fallback_cancelled(esphome::JHSClimate::JHSClimate &climate, int64_t &now, std::mt19937 &rng)
+{
+    // the AC frames are rewritten while the wifi is down, so the main loop takes the AC->panel line back
+    esphome::wifi::global_wifi_component->connected = false;
+    for (int i = 0; i < 2; i++)
+    {
+        now += FRAME_PERIOD_US;
+        host_set_time_us(now);
+        climate.loop();
+    }
+    CHECK(!ac_to_panel_passthrough());
+
+    fill_ac_queue(now, rng);
+    uint32_t overflows = jhs_rx_queue_overflows();
+    play_edges(AC_RX_PIN, frame_edges(random_ac_frame(rng), now));
+    CHECK(jhs_rx_queue_overflows() == overflows + 1);
+    // the main loop runs again before the next frame and forwards the queued frames itself
+    now += FRAME_PERIOD_US;
+    host_set_time_us(now);
+    climate.loop();
+    play_edges(AC_RX_PIN, frame_edges(random_ac_frame(rng), now));
+    CHECK(!ac_to_panel_passthrough());
+}
+
+int main()
+{
+    std::mt19937 rng(27);
+    esphome::InternalGPIOPin ac_tx_pin(AC_TX_PIN);
+    esphome::InternalGPIOPin ac_rx_pin(AC_RX_PIN);
+    esphome::InternalGPIOPin panel_tx_pin(PANEL_TX_PIN);
+    esphome::InternalGPIOPin panel_rx_pin(PANEL_RX_PIN);
+    esphome::binary_sensor::BinarySensor water_full_sensor;
+    esphome::JHSClimate::JHSClimate climate;
+    climate.set_ac_tx_pin(&ac_tx_pin);
+    climate.set_ac_rx_pin(&ac_rx_pin);
+    climate.set_panel_tx_pin(&panel_tx_pin);
+    climate.set_panel_rx_pin(&panel_rx_pin);
+    climate.set_water_full_sensor(&water_full_sensor);
+    climate.set_passthrough(true);
+    int64_t now = 1000000;
+    host_set_time_us(now);
+    climate.setup();
+
+    test_fallback_on_frame_boundary(now, rng);
+    test_fallback_cancelled(climate, now, rng);
+    return check_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// The AC->panel rewrite stages: every stage is applied to random frames in place and compared with the same change
+// made to the parsed packet and serialised again, which also checks the incrementally patched checksum against a full
+// recompute. A timing loop compares the whole chain with re-serialising the frame.
+
+#include <chrono>
+#include "jhs_test.h"
+#include "jhs_rewrite.h"
+
+using namespace esphome::JHSClimate;
+
+static const int FRAMES = 1000;
+static const int TIMING_FRAMES = 1000000;
+// keeps the timed loops from being optimised away
+static volatile uint8_t sink;
+
+///@brief A random frame which also asks the panel to beep now and then.
+static std::vector<uint8_t> random_frame(std::mt19937 &rng)
+{
+    JHSAcPacket packet = *JHSAcPacket::parse(random_ac_frame(rng));
+    packet.wifi = rng() % 2;
+    packet.beep_length = rng() % 16;
+    packet.beep_amount = rng() % 16;
+    return packet.to_wire_format();
+}
+
+///@brief Applies a stage to a copy of the frame and checks it against the expected change of the packet.
+template <typename Stage, typename Change>
+static void check_stage(const Stage &stage, const std::vector<uint8_t> &frame, const JHSRewriteContext &ctx, Change change)
+{
+    std::vector<uint8_t> rewritten = frame;
+    stage.apply(rewritten.data(), ctx);
+    JHSAcPacket packet = *JHSAcPacket::parse(frame);
+    change(packet);
+    CHECK(rewritten == packet.to_wire_format());
+    CHECK(JHSAcPacket::is_checksum_valid(rewritten.data()));
+}
+
+static void test_wifi_icon(std::mt19937 &rng)
+{
+    JHSWifiIconRewrite stage;
+    for (int i = 0; i < FRAMES; i++)
+    {
+        std::vector<uint8_t> frame = random_frame(rng);
+        check_stage(stage, frame, {.wifi_connected = true, .adjusting = false}, [](JHSAcPacket &packet)
+                    { packet.wifi = 0; });
+        check_stage(stage, frame, {.wifi_connected = false, .adjusting = false}, [](JHSAcPacket &packet)
+                    { packet.wifi = 1; });
+    }
+    stage.enabled = false;
+    std::vector<uint8_t> frame = random_frame(rng);
+    check_stage(stage, frame, {.wifi_connected = false, .adjusting = false}, [](JHSAcPacket &packet) {});
+}
+
+static void test_beep(std::mt19937 &rng)
+{
+    auto mute = [](JHSAcPacket &packet)
+    {
+        packet.beep_length = 0;
+        packet.beep_amount = 0;
+    };
+    auto keep = [](JHSAcPacket &packet) {};
+    JHSBeepRewrite stage;
+    for (int i = 0; i < FRAMES; i++)
+    {
+        std::vector<uint8_t> frame = random_frame(rng);
+        stage.policy = JHS_BEEP_POLICY_NORMAL;
+        check_stage(stage, frame, {.wifi_connected = true, .adjusting = true}, keep);
+        stage.policy = JHS_BEEP_POLICY_MUTE_WHILE_ADJUSTING;
+        check_stage(stage, frame, {.wifi_connected = true, .adjusting = false}, keep);
+        check_stage(stage, frame, {.wifi_connected = true, .adjusting = true}, mute);
+        stage.policy = JHS_BEEP_POLICY_MUTE;
+        check_stage(stage, frame, {.wifi_connected = true, .adjusting = false}, mute);
+    }
+}
+
+static void test_display(std::mt19937 &rng)
+{
+    JHSDisplayRewrite stage;
+    // not enabled until a text is set
+    check_stage(stage, random_frame(rng), {.wifi_connected = true, .adjusting = false}, [](JHSAcPacket &packet) {});
+    stage.set_text("dH");
+    CHECK(stage.enabled);
+    for (int i = 0; i < FRAMES; i++)
+    {
+        check_stage(stage, random_frame(rng), {.wifi_connected = true, .adjusting = false}, [](JHSAcPacket &packet)
+                    { packet.set_display("dH"); });
+    }
+    stage.set_text("");
+    CHECK(!stage.enabled);
+}
+
+static void test_chain(std::mt19937 &rng)
+{
+    JHSAcRewriteChain chain;
+    chain.stage<JHSBeepRewrite>().policy = JHS_BEEP_POLICY_MUTE;
+    chain.stage<JHSDisplayRewrite>().set_text("42");
+    for (int i = 0; i < FRAMES; i++)
+    {
+        check_stage(chain, random_frame(rng), {.wifi_connected = false, .adjusting = false}, [](JHSAcPacket &packet)
+                    {
+                        packet.wifi = 1;
+                        packet.beep_length = 0;
+                        packet.beep_amount = 0;
+                        packet.set_temp(42); });
+    }
+}
+
+///@brief Nanoseconds per frame of the whole chain and of the same change made by re-serialising the packet.
+static void test_timing(std::mt19937 &rng)
+{
+    JHSAcRewriteChain chain;
+    chain.stage<JHSBeepRewrite>().policy = JHS_BEEP_POLICY_MUTE;
+    chain.stage<JHSDisplayRewrite>().set_text("42");
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < 256; i++)
+        frames.push_back(random_frame(rng));
+    JHSRewriteContext ctx = {.wifi_connected = false, .adjusting = false};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TIMING_FRAMES; i++)
+    {
+        std::vector<uint8_t> &frame = frames[i & 255];
+        chain.apply(frame.data(), ctx);
+        sink = frame[JHS_AC_CHECKSUM_BYTE];
+    }
+    auto chain_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < TIMING_FRAMES; i++)
+    {
+        std::vector<uint8_t> &frame = frames[i & 255];
+        JHSAcPacket packet = *JHSAcPacket::parse(frame);
+        packet.wifi = 1;
+        packet.beep_length = 0;
+        packet.beep_amount = 0;
+        packet.set_temp(42);
+        frame = packet.to_wire_format();
+        sink = frame[JHS_AC_CHECKSUM_BYTE];
+    }
+    auto serialise_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    double chain_per_frame = (double)chain_ns / TIMING_FRAMES;
+    double serialise_per_frame = (double)serialise_ns / TIMING_FRAMES;
+    printf("rewrite chain: %.1f ns per frame, parse and re-serialise: %.1f ns per frame\n",
+           chain_per_frame, serialise_per_frame);
+    CHECK(chain_per_frame < serialise_per_frame);
+}
+
+int main()
+{
+    std::mt19937 rng(26);
+    test_wifi_icon(rng);
+    test_beep(rng);
+    test_display(rng);
+    test_chain(rng);
+    test_timing(rng);
+    return check_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// JHSRuntimeStats: time between frames is counted towards the state of the earlier frame unless the gap is too long,
+// fan speeds only count while the AC runs, water tank events are rising edges, and the totals survive being saved to
+// and loaded from the preferences.
+
+#include <cstring>
+#include "jhs_test.h"
+#include "jhs_runtime.h"
+#include "esphome/core/preferences.h"
+
+static const uint32_t FRAME_MS = 100;
+
+static JHSAcPacket cooling(bool fan_high)
+{
+    JHSAcPacket packet;
+    packet.cool = 1;
+    packet.fan_low = !fan_high;
+    packet.fan_high = fan_high;
+    return packet;
+}
+
+static void test_gap_cutoff()
+{
+    JHSRuntimeStats stats;
+    JHSAcPacket packet = cooling(false);
+    uint32_t now = 1000;
+    stats.update(packet, false, now);
+    // the first frame has nothing before it
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_COOL] == 0);
+    for (int i = 0; i < 10; i++)
+    {
+        now += FRAME_MS;
+        stats.update(packet, false, now);
+    }
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_COOL] == 10 * FRAME_MS);
+    // a gap of exactly the limit still counts, a longer one does not
+    now += JHS_RUNTIME_MAX_GAP_MS;
+    stats.update(packet, false, now);
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_COOL] == 10 * FRAME_MS + JHS_RUNTIME_MAX_GAP_MS);
+    now += JHS_RUNTIME_MAX_GAP_MS + 1;
+    stats.update(packet, false, now);
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_COOL] == 10 * FRAME_MS + JHS_RUNTIME_MAX_GAP_MS);
+    // counting resumes with the next frame
+    now += FRAME_MS;
+    stats.update(packet, false, now);
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_COOL] == 11 * FRAME_MS + JHS_RUNTIME_MAX_GAP_MS);
+    // across the wrap of millis()
+    now = UINT32_MAX - FRAME_MS / 2;
+    stats.update(packet, false, now);
+    stats.update(packet, false, now + FRAME_MS);
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_COOL] == 12 * FRAME_MS + JHS_RUNTIME_MAX_GAP_MS);
+}
+
+static void test_fan_only_while_on()
+{
+    JHSRuntimeStats stats;
+    JHSAcPacket off;
+    off.power = 0;
+    off.fan_high = 1;
+    uint32_t now = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        stats.update(off, false, now);
+        now += FRAME_MS;
+    }
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_FAN_HIGH] == 0);
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_COOL] == 0);
+
+    JHSAcPacket high = cooling(true);
+    for (int i = 0; i < 10; i++)
+    {
+        stats.update(high, false, now);
+        now += FRAME_MS;
+    }
+    JHSAcPacket low = cooling(false);
+    low.cool = 0;
+    low.dehum = 1;
+    for (int i = 0; i < 5; i++)
+    {
+        stats.update(low, false, now);
+        now += FRAME_MS;
+    }
+    stats.update(off, false, now);
+    // the time from the last off frame to the first cool frame counts as off
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_FAN_HIGH] == 10 * FRAME_MS);
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_FAN_LOW] == 5 * FRAME_MS);
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_COOL] == 10 * FRAME_MS);
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_DEHUM] == 5 * FRAME_MS);
+}
+
+static void test_water_full_events()
+{
+    JHSRuntimeStats stats;
+    JHSAcPacket packet = cooling(false);
+    // full at boot is not a new event
+    const bool water_full[] = {true, true, false, true, true, true, false, false, true};
+    uint32_t now = 0;
+    for (bool full : water_full)
+    {
+        stats.update(packet, full, now);
+        now += FRAME_MS;
+    }
+    CHECK(stats.get_water_full_events() == 2);
+    // 2 + 3 frame intervals after full frames, the last frame has nothing after it
+    CHECK(stats.get_totals().runtime_ms[JHS_RUNTIME_WATER_FULL] == 5 * FRAME_MS);
+}
+
+static void test_preferences_round_trip()
+{
+    JHSRuntimeStats stats;
+    uint32_t now = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        JHSAcPacket packet = cooling(i % 3 == 0);
+        packet.sleep = i % 4 == 0;
+        stats.update(packet, i % 10 < 5, now);
+        now += FRAME_MS;
+    }
+    esphome::ESPPreferenceObject pref = esphome::global_preferences->make_preference<JHSRuntimeTotals>(0x52554E54);
+    CHECK(pref.save(&stats.get_totals()));
+
+    JHSRuntimeStats restored;
+    CHECK(pref.load(&restored.get_totals()));
+    CHECK(memcmp(&restored.get_totals(), &stats.get_totals(), sizeof(JHSRuntimeTotals)) == 0);
+    for (int i = 0; i < JHS_RUNTIME_COUNTERS; i++)
+        CHECK(restored.get_hours((JHSRuntimeCounter)i) == stats.get_hours((JHSRuntimeCounter)i));
+    CHECK(restored.get_water_full_events() == stats.get_water_full_events());
+
+    // the restored totals keep counting, the frame before the reboot is not carried over
+    uint64_t cool = restored.get_totals().runtime_ms[JHS_RUNTIME_COOL];
+    restored.update(cooling(false), false, now);
+    restored.update(cooling(false), false, now + FRAME_MS);
+    CHECK(restored.get_totals().runtime_ms[JHS_RUNTIME_COOL] == cool + FRAME_MS);
+}
+
+int main()
+{
+    test_gap_cutoff();
+    test_fan_only_while_on();
+    test_water_full_events();
+    test_preferences_round_trip();
+    return check_failures == 0 ? 0 : 1;
+}
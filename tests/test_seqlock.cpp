@@ -0,0 +1,112 @@
+// JHSSeqlock under contention: one writer thread publishes values as fast as it can while reader threads copy them.
+// Every value is filled from a counter, so a read that mixes two writes shows up, and the counter also checks that
+// readers never go back in time and never see a value older than the version published before the read started.
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "jhs_test.h"
+#include "jhs_seqlock.h"
+
+static const int READERS = 2;
+static const auto RUN_TIME = std::chrono::seconds(1);
+
+// large enough that a copy is regularly interrupted by the writer
+struct Value
+{
+    uint32_t counter;
+    uint32_t words[255];
+};
+
+static Value make_value(uint32_t counter)
+{
+    Value value;
+    value.counter = counter;
+    for (uint32_t i = 0; i < 255; i++)
+        value.words[i] = counter * 2654435761u + i;
+    return value;
+}
+
+static bool is_consistent(const Value &value)
+{
+    for (uint32_t i = 0; i < 255; i++)
+    {
+        if (value.words[i] != value.counter * 2654435761u + i)
+            return false;
+    }
+    return true;
+}
+
+struct ReaderStats
+{
+    uint32_t reads = 0;
+    uint32_t torn = 0;
+    uint32_t backwards = 0;
+    uint32_t stale = 0;
+    uint32_t newer_than_version = 0;
+    uint32_t values_seen = 0;
+};
+
+static void reader(const JHSSeqlock<Value> &seqlock, const std::atomic<bool> &done, ReaderStats &stats)
+{
+    uint32_t last = 0;
+    while (!done.load(std::memory_order_relaxed))
+    {
+        uint32_t version_before = seqlock.get_version();
+        Value value = seqlock.read();
+        uint32_t version_after = seqlock.get_version();
+        stats.reads++;
+        if (!is_consistent(value))
+            stats.torn++;
+        if (value.counter < last)
+            stats.backwards++;
+        // write n publishes counter n
+        if (value.counter < version_before)
+            stats.stale++;
+        if (value.counter > version_after)
+            stats.newer_than_version++;
+        if (value.counter != last)
+            stats.values_seen++;
+        last = value.counter;
+    }
+}
+
+int main()
+{
+    JHSSeqlock<Value> seqlock;
+    // the buffers start zeroed, which is not a valid value
+    uint32_t writes = 1;
+    seqlock.write(make_value(writes));
+    std::atomic<bool> done{false};
+    std::vector<ReaderStats> stats(READERS);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < READERS; i++)
+        readers.emplace_back(reader, std::cref(seqlock), std::cref(done), std::ref(stats[i]));
+
+    auto end = std::chrono::steady_clock::now() + RUN_TIME;
+    while (std::chrono::steady_clock::now() < end)
+    {
+        for (int i = 0; i < 100; i++)
+            seqlock.write(make_value(++writes));
+    }
+    done.store(true);
+    for (std::thread &thread : readers)
+        thread.join();
+
+    CHECK(seqlock.get_version() == writes);
+    CHECK(seqlock.read().counter == writes);
+    printf("%u writes, %u threads on %u cores\n", writes, READERS + 1, std::thread::hardware_concurrency());
+    for (const ReaderStats &reader_stats : stats)
+    {
+        printf("%u reads, %u distinct values, %u torn, %u backwards, %u stale, %u newer than the version\n",
+               reader_stats.reads, reader_stats.values_seen, reader_stats.torn, reader_stats.backwards,
+               reader_stats.stale, reader_stats.newer_than_version);
+        CHECK(reader_stats.reads > 0);
+        CHECK(reader_stats.torn == 0);
+        CHECK(reader_stats.backwards == 0);
+        CHECK(reader_stats.stale == 0);
+        CHECK(reader_stats.newer_than_version == 0);
+    }
+    return check_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,427 @@
+// Soak test of the whole component against a model of the AC and the panel: AC frames with jitter and injected
+// faults go through the RX interrupt handler, jhs_decode_ac_frame() and process_ac_frame(), button presses come
+// back out of the RMT encoder and are applied by the model, and control() calls arrive in overlapping bursts while
+// the main loop is occasionally stalled long enough to overflow the receive queue, for an hour of simulated time or the
+// hours given as the argument. Fails if the share of decoded frames, wrong frames, adjustments which did not converge
+// or the overflow accounting regress past the thresholds, or if the component does not report exactly the adjustments
+// which did not converge. The longest process_ac_frame() call is timed on the CPU clock of the host and must stay below
+// a fixed limit.
+
+#include <algorithm>
+#include <ctime>
+#include <deque>
+#include <queue>
+#include "jhs_test.h"
+#include "jhs_ac_model.h"
+#include "jhs_climate.h"
+
+using namespace esphome::climate;
+using esphome::JHSClimate::JHSAcSnapshot;
+using esphome::JHSClimate::JHSHealthStats;
+
+static const int AC_RX_PIN = 4;
+static const int AC_TX_PIN = 5;
+static const int PANEL_TX_PIN = 18;
+static const int PANEL_RX_PIN = 19;
+
+static const int64_t HOUR_US = 60 * 60 * 1000000LL;
+static const int64_t FRAME_PERIOD_US = 100000;
+// the panel sends a keepalive at the start of every period, the AC answers this much later
+static const int64_t AC_FRAME_OFFSET_US = 35000;
+static const int JITTER_US = 40;
+// share of AC frames with one fault from jhs_test.h injected
+static const double FAULT_RATE = 0.02;
+// the AC applies a press up to this long after it was received, so now and then only the frame after the next one
+// shows it, which the component must not report as a convergence failure
+static const int64_t PRESS_LATENCY_US = 20000;
+// share of presses the AC misses, so some adjustments really do not converge and the component has to notice
+static const double PRESS_LOSS_RATE = 0.01;
+// time the main loop takes between two loop() calls
+static const int64_t LOOP_MIN_US = 8000;
+static const int64_t LOOP_MAX_US = 16000;
+// a burst of control() calls, spaced up to this much, then this long to reach the requested state
+static const int MAX_CALLS_PER_BURST = 3;
+static const int64_t CALL_SPACING_US = 400000;
+static const int64_t SETTLE_US = 8000000;
+// every this many bursts the main loop stops for a while, long enough to fill the AC receive queue
+static const int STALL_EVERY_BURSTS = 40;
+static const int64_t STALL_US = 3000000;
+
+// measured with the seed in Soak() over one and over 30 hours and rounded down (up for the failures), so a regression
+// fails the test at either length. Wrong frames are repairs which picked the wrong bit, adjustments which do not
+// converge lost a press which the component does not retry.
+static const double MIN_DECODED = 0.985;
+static const double MAX_WRONG_SHARE = 0.0001;
+static const double MAX_NOT_CONVERGED = 0.011;
+
+// the longest a process_ac_frame() call may take on the host, about ten times the measured worst case. Even twenty times
+// slower on the ESP32 that leaves most of the AC frame period for the rest of the main loop.
+static const uint32_t MAX_FRAME_PROCESSING_US = 1000;
+
+///@brief CPU time of the calling thread, unlike a wall clock it does not count the time the test was preempted.
+static unsigned long thread_cpu_time_us()
+{
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+class SoakClimate : public esphome::JHSClimate::JHSClimate
+{
+public:
+    SoakClimate() { this->processing_clock_us = thread_cpu_time_us; }
+    // the periodic report clears the health counters, hold it off to keep the totals of the whole run
+    void hold_report() { this->last_stats_report = esphome::millis(); }
+    void force_report() { this->last_stats_report = esphome::millis() - STATS_REPORT_INTERVAL - 1; }
+};
+
+enum EventType
+{
+    EVENT_EDGE,
+    EVENT_PANEL_FRAME,
+    EVENT_AC_FRAME,
+    EVENT_LOOP,
+    EVENT_CALL,
+    EVENT_CHECK,
+};
+
+struct Event
+{
+    int64_t time;
+    // keeps events at the same time in the order they were scheduled
+    uint64_t order;
+    EventType type;
+    int pin;
+
+    bool operator>(const Event &other) const { return time != other.time ? time > other.time : order > other.order; }
+};
+
+struct Press
+{
+    int64_t applied_at;
+    std::vector<uint8_t> frame;
+};
+
+struct Requested
+{
+    ClimateMode mode;
+    ClimateFanMode fan_mode;
+    ClimatePreset preset;
+    int temp;
+};
+
+class Soak
+{
+public:
+    Soak(int64_t duration_us) : rng(34), press_loss_rng(341), duration_us(duration_us) {}
+
+    void run()
+    {
+        this->climate.set_ac_tx_pin(&this->ac_tx_pin);
+        this->climate.set_ac_rx_pin(&this->ac_rx_pin);
+        this->climate.set_panel_tx_pin(&this->panel_tx_pin);
+        this->climate.set_panel_rx_pin(&this->panel_rx_pin);
+        this->climate.set_water_full_sensor(&this->water_full_sensor);
+        // frames are forwarded to the panel unchanged, so they can be compared with what the AC sent
+        this->climate.set_wifi_icon(false);
+        host_set_time_us(1000000);
+        this->climate.setup();
+        // the hello frame
+        host_take_rmt_writes(PANEL_TX_PIN);
+
+        this->requested = {this->ac.climate_mode(), this->ac.climate_fan_mode(), this->ac.climate_preset(), this->ac.setpoint};
+        int64_t start = host_time_us();
+        this->schedule(start, EVENT_PANEL_FRAME);
+        this->schedule(start + AC_FRAME_OFFSET_US, EVENT_AC_FRAME);
+        this->schedule(start + LOOP_MIN_US, EVENT_LOOP);
+        // the AC reports its state first
+        this->schedule(start + 2000000, EVENT_CALL);
+
+        while (!this->events.empty() && this->events.top().time < start + this->duration_us)
+        {
+            Event event = this->events.top();
+            this->events.pop();
+            host_set_time_us(event.time);
+            this->handle(event);
+        }
+        this->report();
+    }
+
+protected:
+    void schedule(int64_t time, EventType type, int pin = -1) { this->events.push({time, this->next_order++, type, pin}); }
+
+    void handle(const Event &event)
+    {
+        switch (event.type)
+        {
+        case EVENT_EDGE:
+            host_trigger_gpio_isr(event.pin);
+            break;
+        case EVENT_PANEL_FRAME:
+            this->send_frame(PANEL_RX_PIN, std::vector<uint8_t>(KEEPALIVE_PACKET.begin(), KEEPALIVE_PACKET.end()), false);
+            this->schedule(event.time + FRAME_PERIOD_US, EVENT_PANEL_FRAME);
+            break;
+        case EVENT_AC_FRAME:
+            this->send_ac_frame();
+            this->schedule(event.time + FRAME_PERIOD_US, EVENT_AC_FRAME);
+            break;
+        case EVENT_LOOP:
+            this->run_loop();
+            this->schedule(event.time + this->uniform(LOOP_MIN_US, LOOP_MAX_US), EVENT_LOOP);
+            break;
+        case EVENT_CALL:
+            this->call();
+            if (++this->calls_in_burst < this->burst_size)
+            {
+                this->schedule(event.time + this->uniform(0, CALL_SPACING_US), EVENT_CALL);
+            }
+            else
+            {
+                this->schedule(event.time + SETTLE_US, EVENT_CHECK);
+            }
+            break;
+        case EVENT_CHECK:
+            this->check();
+            this->start_burst(event.time);
+            break;
+        }
+    }
+
+    int64_t uniform(int64_t min, int64_t max) { return std::uniform_int_distribution<int64_t>(min, max)(this->rng); }
+
+    void send_frame(int pin, const std::vector<uint8_t> &frame, bool faults)
+    {
+        std::vector<int64_t> edges = frame_edges(frame, host_time_us());
+        for (int64_t &edge : edges)
+        {
+            edge += this->uniform(-JITTER_US, JITTER_US);
+        }
+        // the first edge stays put, nothing may happen before the current time
+        edges[0] = host_time_us();
+        if (faults && std::bernoulli_distribution(FAULT_RATE)(this->rng))
+        {
+            inject_fault((Fault)this->uniform(FAULT_NONE + 1, FAULT_COUNT - 1), frame, edges, JITTER_US, this->rng);
+        }
+        for (int64_t edge : edges)
+        {
+            this->schedule(edge, EVENT_EDGE, pin);
+        }
+    }
+
+    void send_ac_frame()
+    {
+        // the panel line delivered everything written to the AC TX pin, the AC acts on it with some delay
+        for (HostRmtWrite &write : host_take_rmt_writes(AC_TX_PIN))
+        {
+            if (std::bernoulli_distribution(PRESS_LOSS_RATE)(this->press_loss_rng))
+                continue;
+            int64_t received = write.time_us + jhs_rmt_duration(write.items.data(), write.items.size());
+            this->presses.push_back({received + this->uniform(0, PRESS_LATENCY_US), rmt_items_frame(write.items.data(), write.items.size())});
+        }
+        std::stable_sort(this->presses.begin(), this->presses.end(), [](const Press &a, const Press &b) { return a.applied_at < b.applied_at; });
+        while (!this->presses.empty() && this->presses.front().applied_at <= host_time_us())
+        {
+            this->ac.press(this->presses.front().frame);
+            this->presses.pop_front();
+        }
+
+        std::vector<uint8_t> frame = this->ac.frame();
+        this->sent_frames.push_back(frame);
+        if (this->sent_frames.size() > 64)
+            this->sent_frames.pop_front();
+        this->frames_played++;
+        this->send_frame(AC_RX_PIN, frame, true);
+    }
+
+    bool was_sent(const std::vector<uint8_t> &frame) const
+    {
+        return std::find(this->sent_frames.begin(), this->sent_frames.end(), frame) != this->sent_frames.end();
+    }
+
+    void run_loop()
+    {
+        if (host_time_us() < this->stalled_until)
+            return;
+        if (this->stalled_until > 0)
+        {
+            // the first loop() after a stall, every frame which did not fit the queues was counted
+            uint32_t overflows = jhs_rx_queue_overflows() - this->overflows_before_stall;
+            CHECK(overflows > 0);
+            this->stall_overflows += overflows;
+            this->stalls++;
+            this->stalled_until = 0;
+        }
+        this->climate.hold_report();
+        this->climate.loop();
+
+        for (HostRmtWrite &write : host_take_rmt_writes(PANEL_TX_PIN))
+        {
+            this->frames_forwarded++;
+            if (!this->was_sent(rmt_items_frame(write.items.data(), write.items.size())))
+                this->wrong_forwarded++;
+        }
+        if (this->climate.get_snapshot_version() != this->snapshot_version)
+        {
+            JHSAcSnapshot snapshot = this->climate.get_snapshot();
+            this->snapshot_version = this->climate.get_snapshot_version();
+            if (!this->was_sent(snapshot.packet.to_wire_format()))
+                this->wrong_snapshots++;
+        }
+    }
+
+    void start_burst(int64_t now)
+    {
+        if (++this->bursts % STALL_EVERY_BURSTS == 0)
+        {
+            // nothing runs loop() in the meantime, the frames pile up in the receive queues
+            this->stalled_until = now + STALL_US;
+            this->overflows_before_stall = jhs_rx_queue_overflows();
+            now = this->stalled_until;
+        }
+        this->burst_size = 1 + this->uniform(0, MAX_CALLS_PER_BURST - 1);
+        this->calls_in_burst = 0;
+        this->schedule(now + this->uniform(0, CALL_SPACING_US), EVENT_CALL);
+    }
+
+    void call()
+    {
+        ClimateCall call = this->climate.make_call();
+        // fan, preset and temperature only make sense while the AC is on, the temperature only when cooling
+        int choices = this->requested.mode == CLIMATE_MODE_OFF ? 1 : this->requested.mode == CLIMATE_MODE_COOL ? 4 : 3;
+        switch (this->uniform(0, choices - 1))
+        {
+        case 0:
+        {
+            const ClimateMode modes[] = {CLIMATE_MODE_OFF, CLIMATE_MODE_COOL, CLIMATE_MODE_DRY, CLIMATE_MODE_FAN_ONLY};
+            this->requested.mode = modes[this->uniform(0, 3)];
+            call.set_mode(this->requested.mode);
+            break;
+        }
+        case 1:
+            this->requested.fan_mode = this->requested.fan_mode == CLIMATE_FAN_LOW ? CLIMATE_FAN_HIGH : CLIMATE_FAN_LOW;
+            call.set_fan_mode(this->requested.fan_mode);
+            break;
+        case 2:
+            this->requested.preset = this->requested.preset == CLIMATE_PRESET_NONE ? CLIMATE_PRESET_SLEEP : CLIMATE_PRESET_NONE;
+            call.set_preset(this->requested.preset);
+            break;
+        default:
+            this->requested.temp = this->uniform(JHS_AC_MIN_SETPOINT, JHS_AC_MAX_SETPOINT);
+            call.set_target_temperature(this->requested.temp);
+            break;
+        }
+        call.perform();
+        this->calls++;
+    }
+
+    void check()
+    {
+        bool converged = this->ac.climate_mode() == this->requested.mode;
+        if (this->requested.mode != CLIMATE_MODE_OFF)
+        {
+            converged &= this->ac.climate_fan_mode() == this->requested.fan_mode;
+            converged &= this->ac.climate_preset() == this->requested.preset;
+        }
+        if (this->requested.mode == CLIMATE_MODE_COOL)
+            converged &= this->ac.setpoint == this->requested.temp;
+        this->checks++;
+        if (!converged)
+        {
+            this->not_converged++;
+        }
+        // like a user looking at the AC, the next requests start from where it ended up
+        this->requested = {this->ac.climate_mode(), this->ac.climate_fan_mode(), this->ac.climate_preset(), this->ac.setpoint};
+        // whatever happened, the state published to Home Assistant is the one of the AC by now
+        if (this->climate.mode != this->ac.climate_mode())
+            this->stale_state++;
+    }
+
+    void report()
+    {
+        JHSHealthStats health = this->climate.get_health();
+        uint32_t decoded = health.ac_frames_valid + health.ac_frames_repaired;
+        double decoded_share = (double)decoded / (this->frames_played - this->stall_overflows);
+        double not_converged_share = (double)this->not_converged / this->checks;
+        printf("%u AC frames, %u decoded (%u valid, %u repaired), %u unrecoverable, %.2f%% of the frames not lost in a queue overflow\n",
+               this->frames_played, decoded, health.ac_frames_valid, health.ac_frames_repaired, health.ac_frames_unrecoverable, 100 * decoded_share);
+        printf("%u forwarded to the panel, %u wrong, %u wrong snapshots\n", this->frames_forwarded, this->wrong_forwarded, this->wrong_snapshots);
+        printf("%u control() calls in %u bursts, %u not converged (%.2f%%), %u convergence failures reported, %u stale states\n",
+               this->calls, this->checks, this->not_converged, 100 * not_converged_share, health.convergence_failures, this->stale_state);
+        printf("%u stalls, %u queue overflows, %u reported\n", this->stalls, this->stall_overflows, health.queue_overflows);
+        printf("longest process_ac_frame(): %u us\n", health.max_frame_processing_us);
+
+        CHECK(decoded_share >= MIN_DECODED);
+        CHECK(this->wrong_forwarded <= MAX_WRONG_SHARE * this->frames_forwarded);
+        CHECK(this->wrong_snapshots <= MAX_WRONG_SHARE * this->frames_forwarded);
+        CHECK(not_converged_share <= MAX_NOT_CONVERGED);
+        // every burst which did not converge is reported, and none which did
+        CHECK(this->not_converged > 0);
+        CHECK(health.convergence_failures == this->not_converged);
+        CHECK(this->stale_state == 0);
+        CHECK(health.max_frame_processing_us > 0);
+        CHECK(health.max_frame_processing_us <= MAX_FRAME_PROCESSING_US);
+        // every overflow happened during a stall and was counted
+        CHECK(this->stalls > 0);
+        CHECK(health.queue_overflows == this->stall_overflows);
+        CHECK(jhs_rx_queue_overflows() == this->stall_overflows);
+
+        // the report clears the counters, the next one starts from zero
+        this->climate.force_report();
+        this->climate.loop();
+        health = this->climate.get_health();
+        CHECK(health.ac_frames_valid == 0 && health.ac_frames_repaired == 0 && health.ac_frames_unrecoverable == 0);
+        CHECK(health.queue_overflows == 0);
+        CHECK(health.convergence_failures == 0);
+        CHECK(health.max_frame_processing_us == 0);
+    }
+
+    std::mt19937 rng;
+    // a stream of its own, so the lost presses do not shift the faults and timing drawn from rng
+    std::mt19937 press_loss_rng;
+    int64_t duration_us;
+    AcModel ac;
+    SoakClimate climate;
+    esphome::InternalGPIOPin ac_tx_pin{AC_TX_PIN};
+    esphome::InternalGPIOPin ac_rx_pin{AC_RX_PIN};
+    esphome::InternalGPIOPin panel_tx_pin{PANEL_TX_PIN};
+    esphome::InternalGPIOPin panel_rx_pin{PANEL_RX_PIN};
+    esphome::binary_sensor::BinarySensor water_full_sensor;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    uint64_t next_order = 0;
+    std::deque<Press> presses;
+    std::deque<std::vector<uint8_t>> sent_frames;
+    uint32_t snapshot_version = 0;
+    int64_t stalled_until = 0;
+    uint32_t overflows_before_stall = 0;
+
+    Requested requested;
+    int burst_size = 1;
+    int calls_in_burst = 0;
+
+    uint32_t frames_played = 0;
+    uint32_t frames_forwarded = 0;
+    uint32_t wrong_forwarded = 0;
+    uint32_t wrong_snapshots = 0;
+    uint32_t calls = 0;
+    uint32_t bursts = 0;
+    uint32_t checks = 0;
+    uint32_t not_converged = 0;
+    uint32_t stale_state = 0;
+    uint32_t stalls = 0;
+    uint32_t stall_overflows = 0;
+};
+
+int main(int argc, char **argv)
+{
+    // simulated hours, one by default, see the README for a long run
+    double hours = argc > 1 ? atof(argv[1]) : 1;
+    if (hours <= 0)
+    {
+        fprintf(stderr, "usage: %s [hours]\n", argv[0]);
+        return 2;
+    }
+    Soak soak((int64_t)(hours * HOUR_US));
+    soak.run();
+    return check_failures == 0 ? 0 : 1;
+}
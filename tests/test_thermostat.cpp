@@ -0,0 +1,167 @@
+// JHSThermostat: hysteresis switching, PID saturation and anti-windup, and that readings which are not finite
+// neither produce a setpoint nor leak into the controller history. Also that the component keeps regulating the room
+// after a reboot, with the saved target or, without one, the AC setpoint.
+
+#include <cmath>
+#include <limits>
+#include "jhs_test.h"
+#include "jhs_climate.h"
+#include "jhs_thermostat.h"
+
+static const float NOT_A_NUMBER = std::numeric_limits<float>::quiet_NaN();
+static const float INFINITE = std::numeric_limits<float>::infinity();
+
+static void test_hysteresis()
+{
+    JHSThermostat thermostat;
+    thermostat.set_hysteresis(0.5f);
+    CHECK(thermostat.update(24.0f, 24.0f, 0) == JHS_AC_MAX_SETPOINT);
+    CHECK(thermostat.update(24.5f, 24.0f, 1000) == JHS_AC_MIN_SETPOINT);
+    // keeps cooling inside the band
+    CHECK(thermostat.update(24.0f, 24.0f, 2000) == JHS_AC_MIN_SETPOINT);
+    CHECK(thermostat.update(23.5f, 24.0f, 3000) == JHS_AC_MAX_SETPOINT);
+    CHECK(thermostat.update(24.2f, 24.0f, 4000) == JHS_AC_MAX_SETPOINT);
+}
+
+static void test_hysteresis_not_finite()
+{
+    JHSThermostat thermostat;
+    CHECK(thermostat.update(25.0f, 24.0f, 0) == JHS_AC_MIN_SETPOINT);
+    CHECK(thermostat.update(NOT_A_NUMBER, 24.0f, 1000) == -1);
+    CHECK(thermostat.update(25.0f, NOT_A_NUMBER, 2000) == -1);
+    CHECK(thermostat.update(-INFINITE, 24.0f, 3000) == -1);
+    // still cooling, the invalid readings did not switch it off
+    CHECK(thermostat.update(24.0f, 24.0f, 4000) == JHS_AC_MIN_SETPOINT);
+}
+
+static void test_pid()
+{
+    JHSThermostat thermostat;
+    thermostat.set_type(JHS_THERMOSTAT_PID);
+    thermostat.set_pid(2.0f, 0.0f, 0.0f);
+    CHECK(thermostat.update(24.0f, 24.0f, 0) == 24);
+    CHECK(thermostat.update(25.0f, 24.0f, 1000) == 22);
+    CHECK(thermostat.update(23.0f, 24.0f, 2000) == 26);
+    CHECK(thermostat.update(40.0f, 24.0f, 3000) == JHS_AC_MIN_SETPOINT);
+    CHECK(thermostat.update(10.0f, 24.0f, 4000) == JHS_AC_MAX_SETPOINT);
+}
+
+static void test_pid_anti_windup()
+{
+    JHSThermostat thermostat;
+    thermostat.set_type(JHS_THERMOSTAT_PID);
+    thermostat.set_pid(0.0f, 0.1f, 0.0f);
+    // the first update has no time step to integrate over
+    CHECK(thermostat.update(40.0f, 24.0f, 0) == 24);
+    // saturated for a long time, the integral must not grow
+    for (uint32_t t = 60000; t <= 3600000; t += 60000)
+    {
+        CHECK(thermostat.update(40.0f, 24.0f, t) == JHS_AC_MIN_SETPOINT);
+    }
+    // back at the target the output returns to it right away
+    CHECK(thermostat.update(24.0f, 24.0f, 3660000) == 24);
+}
+
+static void test_pid_not_finite()
+{
+    // the same readings with invalid ones in between must give the same setpoints, only the time moves on
+    JHSThermostat reference;
+    JHSThermostat thermostat;
+    for (JHSThermostat *t : {&reference, &thermostat})
+    {
+        t->set_type(JHS_THERMOSTAT_PID);
+        t->set_pid(1.0f, 0.01f, 20.0f);
+    }
+    const float rooms[] = {26.0f, 25.6f, 25.1f, 24.8f, 24.3f, 24.1f, 23.9f, 24.0f};
+    uint32_t now = 0;
+    for (float room : rooms)
+    {
+        now += 30000;
+        CHECK(thermostat.update(NOT_A_NUMBER, 24.0f, now - 20000) == -1);
+        CHECK(thermostat.update(room, NOT_A_NUMBER, now - 10000) == -1);
+        CHECK(thermostat.update(room, INFINITE, now - 5000) == -1);
+        CHECK(thermostat.update(room, 24.0f, now) == reference.update(room, 24.0f, now));
+    }
+}
+
+static const int AC_RX_PIN = 4;
+static const int AC_TX_PIN = 5;
+static const int PANEL_RX_PIN = 6;
+static const int PANEL_TX_PIN = 7;
+
+///@brief A JHSClimate regulating the room with a sensor, as set up after a boot.
+struct RoomThermostat
+{
+    esphome::InternalGPIOPin ac_tx_pin{AC_TX_PIN};
+    esphome::InternalGPIOPin ac_rx_pin{AC_RX_PIN};
+    esphome::InternalGPIOPin panel_tx_pin{PANEL_TX_PIN};
+    esphome::InternalGPIOPin panel_rx_pin{PANEL_RX_PIN};
+    esphome::binary_sensor::BinarySensor water_full_sensor;
+    esphome::sensor::Sensor room_sensor;
+    esphome::JHSClimate::JHSClimate climate;
+
+    RoomThermostat()
+    {
+        this->climate.set_ac_tx_pin(&this->ac_tx_pin);
+        this->climate.set_ac_rx_pin(&this->ac_rx_pin);
+        this->climate.set_panel_tx_pin(&this->panel_tx_pin);
+        this->climate.set_panel_rx_pin(&this->panel_rx_pin);
+        this->climate.set_water_full_sensor(&this->water_full_sensor);
+        this->climate.set_room_sensor(&this->room_sensor);
+        this->climate.setup();
+        host_take_rmt_writes(PANEL_TX_PIN);
+    }
+
+    ///@brief The AC reports cooling at the given setpoint 100 ms later, then the main loop runs.
+    void ac_frame(int setpoint)
+    {
+        JHSAcPacket packet;
+        packet.cool = 1;
+        packet.fan_low = 1;
+        packet.set_temp(setpoint);
+        host_advance_time_us(100000);
+        play_edges(AC_RX_PIN, frame_edges(packet.to_wire_format(), host_time_us()));
+        host_advance_time_us(80000);
+        this->climate.loop();
+    }
+};
+
+static void test_target_after_reboot()
+{
+    host_set_time_us(1000000);
+    {
+        // first boot, nothing saved: the target is taken from the AC
+        RoomThermostat first_boot;
+        CHECK(std::isnan(first_boot.climate.target_temperature));
+        first_boot.ac_frame(25);
+        CHECK(first_boot.climate.target_temperature == 25.0f);
+        esphome::climate::ClimateCall call = first_boot.climate.make_call();
+        call.set_target_temperature(22.0f);
+        call.perform();
+    }
+
+    RoomThermostat reboot;
+    CHECK(reboot.climate.target_temperature == 22.0f);
+    // the AC setpoint does not replace a restored target
+    reboot.ac_frame(24);
+    CHECK(reboot.climate.target_temperature == 22.0f);
+    host_take_rmt_writes(AC_TX_PIN);
+    // a warm room makes the thermostat lower the AC setpoint without Home Assistant
+    reboot.room_sensor.publish_state(26.0f);
+    reboot.ac_frame(24);
+    std::vector<HostRmtWrite> writes = host_take_rmt_writes(AC_TX_PIN);
+    CHECK(writes.size() == 1);
+    if (!writes.empty())
+        CHECK(rmt_items_frame(writes[0].items.data(), writes[0].items.size()) == std::vector<uint8_t>(BUTTON_LOWER_TEMP.begin(), BUTTON_LOWER_TEMP.end()));
+}
+
+int main()
+{
+    test_hysteresis();
+    test_hysteresis_not_finite();
+    test_pid();
+    test_pid_anti_windup();
+    test_pid_not_finite();
+    test_target_after_reboot();
+    return check_failures == 0 ? 0 : 1;
+}
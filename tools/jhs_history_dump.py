@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""Fetches the state history of a jhs_climate node and prints one line per state transition:
+
+    <local time> <mode> <setpoint> [fan_high] [sleep] [water_full] [adjusting]
+
+Timestamps are sent as seconds of uptime, they are converted to local time using the uptime of the node
+at the time of the request. See jhs_history.h for the format.
+"""
+
+import argparse
+import struct
+import sys
+import time
+import urllib.request
+
+MAGIC = b"JH"
+VERSION = 1
+HEADER = struct.Struct("<2sBBIIBBH")
+MODES = ["off", "cool", "dehum", "fan_only", "heat"]
+FLAGS = [(1 << 3, "fan_high"), (1 << 4, "sleep"), (1 << 5, "water_full"), (1 << 6, "adjusting")]
+SETPOINT_FOLLOWS = 1 << 7
+
+
+class DecodeError(Exception):
+    pass
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise DecodeError("truncated varint")
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def decode_history(data):
+    """Returns (uptime s, [(uptime s, flags, setpoint)]), starting with the anchor if it is valid."""
+    if len(data) < HEADER.size:
+        raise DecodeError("response too short")
+    magic, version, anchor_valid, uptime, timestamp, flags, setpoint, length = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise DecodeError(f"unsupported history {magic!r} version {version}")
+    records = data[HEADER.size:]
+    if len(records) != length:
+        raise DecodeError(f"expected {length} bytes of records, got {len(records)}, the ring wrapped during the request")
+
+    states = [(timestamp, flags, setpoint)] if anchor_valid else []
+    pos = 0
+    while pos < len(records):
+        delta, pos = read_varint(records, pos)
+        if pos >= len(records):
+            raise DecodeError("truncated record")
+        flags = records[pos]
+        pos += 1
+        if flags & SETPOINT_FOLLOWS:
+            if pos >= len(records):
+                raise DecodeError("truncated record")
+            setpoint = records[pos]
+            pos += 1
+        timestamp += delta
+        states.append((timestamp, flags & ~SETPOINT_FOLLOWS, setpoint))
+    return uptime, states
+
+
+def describe(flags, setpoint):
+    mode = flags & 0x07
+    parts = [MODES[mode] if mode < len(MODES) else f"mode{mode}", str(setpoint)]
+    parts += [name for bit, name in FLAGS if flags & bit]
+    return " ".join(parts)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("host", help="address of the node, with the port if the web server does not use 80")
+    args = parser.parse_args()
+
+    requested = time.time()
+    with urllib.request.urlopen(f"http://{args.host}/jhs_climate/history", timeout=10) as response:
+        data = response.read()
+    try:
+        uptime, states = decode_history(data)
+    except DecodeError as err:
+        print(f"invalid history: {err}", file=sys.stderr)
+        return 1
+    for timestamp, flags, setpoint in states:
+        when = time.strftime("%Y-%m-%d %H:%M:%S", time.localtime(requested - (uptime - timestamp)))
+        print(f"{when} {describe(flags, setpoint)}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
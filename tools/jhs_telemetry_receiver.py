@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Reference receiver for the jhs_climate UDP telemetry stream.
+
+Listens for datagrams from one or more nodes and prints every decoded frame, one per line:
+
+    <node ip> <timestamp ms> ac|panel <frame hex> [decoded AC state]
+
+See jhs_telemetry.h for the wire format.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+
+MAGIC = b"JT"
+VERSION = 1
+HEADER = struct.Struct("<2sBBHIH")
+AC, PANEL = 0, 1
+FRAME_LEN = {AC: 8, PANEL: 3}
+TYPE_NAMES = {AC: "ac", PANEL: "panel"}
+
+# bit names of bytes 5 and 6 of an AC frame, least significant bit first
+AC_FLAGS = [
+    ["cool", "dehum", "fan", "heat", "sleep", "water_full", "swing", "timer"],
+    ["fan_low", "fan_unused", "fan_high", "wifi", "unused_above_timer", "power", "unused4", "unused5"],
+]
+SEVEN_SEGMENT = {
+    0x3F: "0", 0x06: "1", 0x5B: "2", 0x4F: "3", 0x66: "4", 0x6D: "5", 0x7D: "6", 0x07: "7", 0x7F: "8", 0x6F: "9",
+    0x77: "A", 0x7C: "B", 0x39: "C", 0x5E: "D", 0x79: "E", 0x71: "F", 0x74: "h", 0x76: "H", 0x00: " ",
+}
+
+
+class DecodeError(Exception):
+    pass
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise DecodeError("truncated varint")
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def decode_datagram(data):
+    """Returns (sequence, [(timestamp ms, type, frame bytes)]), AC frames get their checksum back."""
+    if len(data) < HEADER.size:
+        raise DecodeError("datagram too short")
+    magic, version, _, sequence, timestamp, count = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION:
+        raise DecodeError(f"unsupported datagram {magic!r} version {version}")
+
+    previous = {AC: bytearray(FRAME_LEN[AC]), PANEL: bytearray(FRAME_LEN[PANEL])}
+    frames = []
+    pos = HEADER.size
+    for _ in range(count):
+        if pos + 1 > len(data):
+            raise DecodeError("truncated record")
+        frame_type = data[pos]
+        if frame_type not in FRAME_LEN:
+            raise DecodeError(f"unknown frame type {frame_type}")
+        delta, pos = read_varint(data, pos + 1)
+        if pos >= len(data):
+            raise DecodeError("truncated record")
+        mask = data[pos]
+        pos += 1
+        frame = previous[frame_type]
+        for i in range(FRAME_LEN[frame_type]):
+            if mask & (1 << i):
+                if pos >= len(data):
+                    raise DecodeError("truncated record")
+                frame[i] = data[pos]
+                pos += 1
+        timestamp = (timestamp + delta) & 0xFFFFFFFF
+        out = bytes(frame)
+        if frame_type == AC:
+            out += bytes([(90 + sum(out)) & 0xFF])
+        frames.append((timestamp, frame_type, out))
+    return sequence, frames
+
+
+def describe_ac(frame):
+    display = SEVEN_SEGMENT.get(frame[1], "?") + SEVEN_SEGMENT.get(frame[2], "?")
+    flags = [name for byte, names in zip(frame[5:7], AC_FLAGS) for bit, name in enumerate(names) if byte & (1 << bit)]
+    beep = frame[7]
+    if beep:
+        flags.append(f"beep={beep >> 4}x{beep & 0x0F}")
+    return f"DISP:{display} " + " ".join(flags)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=7411)
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    last_sequence = {}
+    while True:
+        data, (host, _) = sock.recvfrom(2048)
+        try:
+            sequence, frames = decode_datagram(data)
+        except DecodeError as err:
+            print(f"{host} invalid datagram: {err}", file=sys.stderr)
+            continue
+        if host in last_sequence and sequence != (last_sequence[host] + 1) & 0xFFFF:
+            print(f"{host} lost datagrams {last_sequence[host] + 1}..{sequence - 1}", file=sys.stderr)
+        last_sequence[host] = sequence
+        for timestamp, frame_type, frame in frames:
+            line = f"{host} {timestamp} {TYPE_NAMES[frame_type]} {frame.hex()}"
+            if frame_type == AC:
+                line += " " + describe_ac(frame)
+            print(line, flush=True)
+
+
+if __name__ == "__main__":
+    main()
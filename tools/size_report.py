@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Reports the flash, IRAM and DRAM used by the jhs_climate component in an ESP32 firmware.
+
+Reads the GNU ld map file of the build. ESPHome does not produce one by default, add this to the node config:
+
+    esphome:
+      platformio_options:
+        build_flags: -Wl,-Map,firmware.map
+
+The map file then ends up in .esphome/build/<node>/firmware.map.
+
+Usage:
+    size_report.py firmware.map                      # print the report
+    size_report.py firmware.map --json new.json      # also save it
+    size_report.py firmware.map --compare old.json   # print the difference to a saved report
+"""
+
+import argparse
+import json
+import re
+import sys
+from collections import defaultdict
+
+# ESP32 memory map, see the "Address Space" chapter of the ESP32 TRM
+REGIONS = [
+    ("iram", 0x40070000, 0x400C0000),
+    ("flash_text", 0x400C2000, 0x40C00000),
+    ("flash_rodata", 0x3F400000, 0x3F800000),
+    ("dram", 0x3FFAE000, 0x40000000),
+]
+
+# input sections, optionally followed on the same line by address, size and object file
+SECTION_RE = re.compile(r"^ (\.\S+)(?:\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(.+))?$")
+CONTINUATION_RE = re.compile(r"^\s+(0x[0-9a-f]+)\s+(0x[0-9a-f]+)\s+(.+)$")
+
+# libraries reported separately: iostream should stay out of the firmware, so it is obvious when it comes back, and
+# std::string, which the component still uses, is kept apart so it does not hide whether iostream is gone
+WATCHED_LIBS = {
+    "iostream": re.compile(r"lib(std)?c\+\+\.a\((ios|iostream|sstream|locale|istream|ostream|streambuf|basic_file)"),
+    "std::string": re.compile(r"lib(std)?c\+\+\.a\(string-inst"),
+}
+
+
+def region_of(addr):
+    for name, start, end in REGIONS:
+        if start <= addr < end:
+            return name
+    return None
+
+
+def parse_map(path):
+    """Yields (section, address, size, object file) for every input section in the map file."""
+    pending = None
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if pending is not None:
+                m = CONTINUATION_RE.match(line)
+                if m:
+                    yield pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3).strip()
+                pending = None
+                continue
+            m = SECTION_RE.match(line)
+            if not m:
+                continue
+            if m.group(2) is None:
+                # long section names are wrapped onto the next line
+                pending = m.group(1)
+            else:
+                yield m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4).strip()
+
+
+def build_report(path, pattern):
+    component = re.compile(pattern)
+    report = {"component": defaultdict(int), "objects": defaultdict(lambda: defaultdict(int))}
+    for name in WATCHED_LIBS:
+        report[name] = defaultdict(int)
+
+    for section, addr, size, obj in parse_map(path):
+        if size == 0 or addr == 0:
+            continue
+        region = region_of(addr)
+        if region is None:
+            continue
+        # .bss and .noinit take up DRAM but no flash
+        if region == "dram" and (section.startswith(".bss") or section.startswith(".noinit")):
+            region = "dram_bss"
+        if component.search(obj):
+            report["component"][region] += size
+            report["objects"][obj.split("/")[-1]][region] += size
+        for name, lib in WATCHED_LIBS.items():
+            if lib.search(obj):
+                report[name][region] += size
+
+    def plain(d):
+        return {k: plain(v) if isinstance(v, dict) else v for k, v in d.items()}
+
+    return plain(report)
+
+
+def totals(regions):
+    flash = regions.get("flash_text", 0) + regions.get("flash_rodata", 0) + regions.get("iram", 0) + regions.get("dram", 0)
+    ram = regions.get("dram", 0) + regions.get("dram_bss", 0)
+    return flash, regions.get("iram", 0), ram
+
+
+def print_row(name, regions, baseline=None):
+    flash, iram, dram = totals(regions)
+    row = f"{name:<40} {flash:>10} {iram:>10} {dram:>10}"
+    if baseline is not None:
+        b_flash, b_iram, b_dram = totals(baseline)
+        row += f"   ({flash - b_flash:+d} / {iram - b_iram:+d} / {dram - b_dram:+d})"
+    print(row)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map_file")
+    parser.add_argument("--pattern", default=r"components/jhs_climate/", help="regex matching the component's object files")
+    parser.add_argument("--json", help="save the report to this file")
+    parser.add_argument("--compare", help="previously saved report to compare against")
+    args = parser.parse_args()
+
+    report = build_report(args.map_file, args.pattern)
+    baseline = None
+    if args.compare:
+        with open(args.compare, encoding="utf-8") as f:
+            baseline = json.load(f)
+
+    print(f"{'bytes':<40} {'flash':>10} {'iram':>10} {'dram':>10}")
+    for obj, regions in sorted(report["objects"].items()):
+        base = baseline["objects"].get(obj, {}) if baseline else None
+        print_row("  " + obj, regions, base)
+    print_row("jhs_climate total", report["component"], baseline["component"] if baseline else None)
+    for name in WATCHED_LIBS:
+        print_row(f"{name} (whole firmware)", report[name], baseline.get(name, {}) if baseline else None)
+
+    if args.json:
+        with open(args.json, "w", encoding="utf-8") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+
+    if baseline is not None:
+        grew = [a > b for a, b in zip(totals(report["component"]), totals(baseline["component"]))]
+        if any(grew):
+            print("jhs_climate footprint grew", file=sys.stderr)
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Round trip of the state history through decode_history().
+
+Runs tests/history_writer.cpp (built by the CMake project in tests/), which records a typical stream of 150 state
+transitions a day into the component's ring and writes the endpoint body to a file while another day is recorded. The
+body must have the announced length, the decoded states must be the ones recorded before the stream was created, and
+the default 4 KB ring must hold a week of them.
+
+    python3 tools/test_jhs_history_dump.py <path to history_writer>
+"""
+
+import subprocess
+import sys
+import tempfile
+import unittest
+
+from jhs_history_dump import decode_history
+
+WRITER = None
+RING_SIZE = 4096
+# seconds since the previous transition take 2 bytes up to 4.5 hours, the setpoint byte only follows when it changed
+MAX_BYTES_PER_TRANSITION = 4.0
+
+
+class HistoryRoundTripTest(unittest.TestCase):
+    def record(self, days):
+        with tempfile.NamedTemporaryFile() as body:
+            output = subprocess.run([WRITER, body.name, str(days)], capture_output=True, text=True, check=True)
+            data = body.read()
+        lines = output.stdout.splitlines()
+        summary = lines.pop().split()
+        recorded = [tuple(int(field) for field in line.split()) for line in lines]
+        self.assertEqual(len(recorded), int(summary[1]))
+        # the Content-Length sent before the body
+        self.assertEqual(len(data), int(summary[3]))
+        return data, recorded, int(summary[2])
+
+    def test_week(self):
+        data, recorded, used = self.record(7)
+        uptime, states = decode_history(data)
+        self.assertEqual(uptime, 7 * 24 * 60 * 60)
+        # nothing was dropped, so there is no anchor
+        self.assertEqual(states, recorded)
+        bytes_per_transition = used / len(recorded)
+        print(f"\n{len(recorded)} transitions in {used} bytes, {bytes_per_transition:.2f} bytes per transition",
+              file=sys.stderr)
+        self.assertLessEqual(bytes_per_transition, MAX_BYTES_PER_TRANSITION)
+
+    def test_wrapped(self):
+        data, recorded, used = self.record(30)
+        _, states = decode_history(data)
+        # the oldest transitions were folded into the anchor, the first state, the rest follow it unchanged
+        self.assertLess(len(states), len(recorded))
+        self.assertEqual(states, recorded[-len(states):])
+        self.assertGreater(used, RING_SIZE - 7)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__, file=sys.stderr)
+        sys.exit(2)
+    WRITER = sys.argv.pop(1)
+    unittest.main()
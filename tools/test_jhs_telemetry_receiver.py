@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Loopback test and benchmark of the telemetry stream.
+
+Runs tests/telemetry_sender.cpp (built by the CMake project in tests/), which encodes a steady stream of frames with
+the component's encoder and sends the datagrams to a socket of this script on 127.0.0.1. Every frame the sender
+reports must come out of decode_datagram() with the same timestamp and content, and the stream must stay compact.
+
+    python3 tools/test_jhs_telemetry_receiver.py <path to telemetry_sender>
+"""
+
+import socket
+import subprocess
+import sys
+import tempfile
+import unittest
+
+from jhs_telemetry_receiver import AC, TYPE_NAMES, decode_datagram
+
+SENDER = None
+FRAMES = 20000
+# a steady stream of unchanging keepalives and AC state with a few changes, one datagram per second: 3 bytes per
+# record, plus the header and the first frame of each line, which has nothing to be compared with
+MAX_BYTES_PER_FRAME = 5.0
+
+
+class TelemetryLoopbackTest(unittest.TestCase):
+    def test_loopback(self):
+        sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+        sock.bind(("127.0.0.1", 0))
+        sock.settimeout(0.5)
+        port = sock.getsockname()[1]
+
+        # the listing is large, a pipe would fill up and block the sender while this loop reads the socket
+        listing = tempfile.TemporaryFile("w+")
+        sender = subprocess.Popen([SENDER, str(port), str(FRAMES)], stdout=listing, text=True)
+        received = []
+        sequences = []
+        while True:
+            try:
+                data, _ = sock.recvfrom(2048)
+            except socket.timeout:
+                # done once the sender exited and everything it sent was read
+                if sender.poll() is not None:
+                    break
+                continue
+            sequence, frames = decode_datagram(data)
+            sequences.append(sequence)
+            received += [f"{timestamp} {TYPE_NAMES[frame_type]} {frame.hex()}" for timestamp, frame_type, frame in frames]
+        sock.close()
+        listing.seek(0)
+        output = listing.read().splitlines()
+        listing.close()
+        self.assertEqual(sender.returncode, 0)
+
+        summary = output.pop().split()
+        frames, datagrams, size, encoding_ns = int(summary[1]), int(summary[2]), int(summary[3]), float(summary[4])
+        self.assertEqual(sequences, list(range(datagrams)), "datagrams lost or reordered on loopback")
+        self.assertEqual(len(output), frames)
+        self.assertEqual(received, output)
+        # every AC frame got its checksum back
+        self.assertTrue(any(line.split()[1] == TYPE_NAMES[AC] for line in received))
+
+        bytes_per_frame = size / frames
+        print(f"\n{frames} frames in {datagrams} datagrams, {bytes_per_frame:.2f} bytes per frame, "
+              f"{encoding_ns:.0f} ns of encoding per frame on this host", file=sys.stderr)
+        self.assertLessEqual(bytes_per_frame, MAX_BYTES_PER_FRAME)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__, file=sys.stderr)
+        sys.exit(2)
+    SENDER = sys.argv.pop(1)
+    unittest.main()